@@ -0,0 +1,300 @@
+#include "CartModel.h"
+#include "DiscountTable.h"
+#include <QBrush>
+#include <QFont>
+
+CartModel::CartModel(const DiscountTable *discounts, QObject *parent)
+        : QAbstractTableModel(parent), discounts(discounts)
+{
+}
+
+void CartModel::setServerCart(const Dto::Cart &cart)
+{
+    server = cart;
+    rebuild();
+}
+
+void CartModel::setPending(const QHash<int, int> &value)
+{
+    if (pending == value)
+    {
+        return;
+    }
+    pending = value;
+    rebuild();
+}
+
+void CartModel::refreshTotals()
+{
+    rebuild();
+}
+
+int CartModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return lines.size() + SummaryRowCount;
+}
+
+int CartModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return ColumnCount;
+}
+
+QVariant CartModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+    {
+        return QVariant();
+    }
+
+    if (index.row() >= lines.size())
+    {
+        return summaryData(index.row() - lines.size(), index.column(), role);
+    }
+
+    const Line &line = lines.at(index.row());
+    if (role == Qt::DisplayRole || role == Qt::EditRole)
+    {
+        switch (index.column())
+        {
+            case NameColumn:
+                return line.name;
+            case QuantityColumn:
+                return role == Qt::EditRole ? QVariant(line.quantity) : QVariant(QString::number(line.quantity));
+            case PriceColumn:
+                return QString::number(line.price, 'f', 2);
+            case SumColumn:
+                return QString::number(line.price * line.quantity, 'f', 2);
+            default:
+                return QVariant();
+        }
+    }
+
+    // Количество, которое сервер ещё не подтвердил, выделяется курсивом
+    if (role == Qt::FontRole && line.unconfirmed && (index.column() == QuantityColumn || index.column() == SumColumn))
+    {
+        QFont font;
+        font.setItalic(true);
+        return font;
+    }
+    return QVariant();
+}
+
+QVariant CartModel::summaryData(int summaryRow, int column, int role) const
+{
+    if (role == Qt::FontRole)
+    {
+        QFont boldFont;
+        boldFont.setBold(true);
+        return boldFont;
+    }
+
+    if (role == Qt::ForegroundRole && summaryRow == PayableRow && column == NameColumn)
+    {
+        return QBrush(Qt::blue);
+    }
+
+    if (role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    if (column == NameColumn)
+    {
+        switch (summaryRow)
+        {
+            case TotalRow:
+                return QString("Итого:");
+            case DiscountRow:
+                return QString("Скидка (%1%)").arg(discountRate * 100, 0, 'f', 1);
+            case PayableRow:
+                return QString("К оплате:");
+            default:
+                return QVariant();
+        }
+    }
+
+    if (column == SumColumn)
+    {
+        switch (summaryRow)
+        {
+            case TotalRow:
+                return QString::number(totalPrice, 'f', 2);
+            case DiscountRow:
+                return QString("-%1").arg(totalPrice - payable, 0, 'f', 2);
+            case PayableRow:
+                return QString::number(payable, 'f', 2);
+            default:
+                return QVariant();
+        }
+    }
+    return QString();
+}
+
+QVariant CartModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+    {
+        return QVariant();
+    }
+
+    switch (section)
+    {
+        case NameColumn:
+            return QString("Товар");
+        case QuantityColumn:
+            return QString("Кол-во");
+        case PriceColumn:
+            return QString("Цена");
+        case SumColumn:
+            return QString("Сумма");
+        default:
+            return QVariant();
+    }
+}
+
+Qt::ItemFlags CartModel::flags(const QModelIndex &index) const
+{
+    Qt::ItemFlags result = QAbstractTableModel::flags(index);
+    if (editable && index.isValid() && index.row() < lines.size() && index.column() == QuantityColumn)
+    {
+        result |= Qt::ItemIsEditable;
+    }
+    return result;
+}
+
+bool CartModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (role != Qt::EditRole || !(flags(index) & Qt::ItemIsEditable))
+    {
+        return false;
+    }
+
+    bool ok = false;
+    const int quantity = value.toInt(&ok);
+    if (!ok || quantity < 0)
+    {
+        return false;
+    }
+
+    const Line &line = lines.at(index.row());
+    const int delta = quantity - line.quantity;
+    if (delta != 0)
+    {
+        // Строка обновится через setPending, когда изменение попадёт в очередь
+        emit quantityChangeRequested(line.productId, delta);
+    }
+    return true;
+}
+
+void CartModel::rebuild()
+{
+    // Корзина сервера с наложенными изменениями; строки одного товара объединяются
+    QVector<Line> next;
+    QHash<int, int> rowOf;
+    for (const Dto::CartItem &item : server.items)
+    {
+        auto it = rowOf.constFind(item.productId);
+        if (it != rowOf.constEnd())
+        {
+            next[it.value()].quantity += item.quantity;
+            continue;
+        }
+        rowOf.insert(item.productId, next.size());
+        next.append({item.productId, item.productName, item.price, item.quantity, false});
+    }
+
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it)
+    {
+        auto row = rowOf.constFind(it.key());
+        if (row != rowOf.constEnd())
+        {
+            Line &line = next[row.value()];
+            line.quantity = qMax(0, line.quantity + it.value());
+            line.unconfirmed = true;
+        }
+    }
+
+    QVector<Line> kept;
+    kept.reserve(next.size());
+    for (const Line &line : next)
+    {
+        if (line.quantity > 0)
+        {
+            kept.append(line);
+        }
+    }
+
+    // Сверка со строками на экране: убрать исчезнувшие, обновить изменившиеся, дописать новые.
+    // Модель не сбрасывается, поэтому выделение и прокрутка таблицы сохраняются
+    QHash<int, int> keptRow;
+    for (int i = 0; i < kept.size(); ++i)
+    {
+        keptRow.insert(kept.at(i).productId, i);
+    }
+
+    for (int row = lines.size() - 1; row >= 0; --row)
+    {
+        if (!keptRow.contains(lines.at(row).productId))
+        {
+            beginRemoveRows(QModelIndex(), row, row);
+            lines.remove(row);
+            endRemoveRows();
+        }
+    }
+
+    QHash<int, int> shownRow;
+    for (int row = 0; row < lines.size(); ++row)
+    {
+        Line &shown = lines[row];
+        shownRow.insert(shown.productId, row);
+        const Line &line = kept.at(keptRow.value(shown.productId));
+        if (shown.quantity != line.quantity || shown.price != line.price ||
+            shown.name != line.name || shown.unconfirmed != line.unconfirmed)
+        {
+            shown = line;
+            emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+        }
+    }
+
+    for (const Line &line : kept)
+    {
+        if (!shownRow.contains(line.productId))
+        {
+            const int row = lines.size();
+            beginInsertRows(QModelIndex(), row, row);
+            lines.append(line);
+            endInsertRows();
+        }
+    }
+
+    // Без неподтверждённых изменений итоги берутся с сервера как есть; иначе считаются по ступеням скидок
+    if (pending.isEmpty() || !discounts || !discounts->isLoaded())
+    {
+        totalPrice = server.totalPrice;
+        discountRate = server.discountRate;
+        payable = server.discountedPrice;
+    }
+    else
+    {
+        int totalItems = 0;
+        totalPrice = 0;
+        for (const Line &line : lines)
+        {
+            totalItems += line.quantity;
+            totalPrice += line.price * line.quantity;
+        }
+        const Dto::Discount *discount = discounts->find(totalItems, totalPrice);
+        discountRate = discount ? discount->rate : 0;
+        payable = qRound64(totalPrice * (1 - discountRate) * 100) / 100.0;
+    }
+
+    emit dataChanged(index(lines.size(), 0), index(lines.size() + SummaryRowCount - 1, ColumnCount - 1));
+}
@@ -0,0 +1,82 @@
+#ifndef HTTP_CLIENT_CARTMODEL_H
+#define HTTP_CLIENT_CARTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVector>
+#include "http_client/http_requests/Dto.h"
+
+class DiscountTable;
+
+// Корзина на стороне клиента: строки товаров и три строки итогов (сумма, скидка, к оплате).
+// Показывается корзина с сервера плюс ещё не подтверждённые изменения количества; итоги со скидкой
+// при этом считаются локально. Ответ сервера сверяется со строками, и перерисовываются только изменившиеся.
+class CartModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        NameColumn,
+        QuantityColumn,
+        PriceColumn,
+        SumColumn,
+        ColumnCount
+    };
+
+    explicit CartModel(const DiscountTable *discounts, QObject *parent = nullptr);
+
+    // Корзина по данным сервера
+    void setServerCart(const Dto::Cart &cart);
+    // Изменения количества, которые ещё не подтвердил сервер (номер товара -> изменение).
+    // Товары, которых нет в корзине сервера, появятся после подтверждения: их названия и цены неизвестны
+    void setPending(const QHash<int, int> &pending);
+    // Пересчитать итоги (например, после загрузки ступеней скидок)
+    void refreshTotals();
+
+    bool isEmpty() const { return lines.isEmpty(); }
+    void setEditable(bool value) { editable = value; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+
+signals:
+    // Пользователь изменил количество в таблице; delta < 0 - уменьшил
+    void quantityChangeRequested(int productId, int delta);
+
+private:
+    struct Line
+    {
+        int productId;
+        QString name;
+        double price;
+        int quantity;
+        bool unconfirmed;
+    };
+
+    enum SummaryRow {
+        TotalRow,
+        DiscountRow,
+        PayableRow,
+        SummaryRowCount
+    };
+
+    void rebuild();
+    QVariant summaryData(int summaryRow, int column, int role) const;
+
+    const DiscountTable *discounts;
+    Dto::Cart server;
+    QHash<int, int> pending;
+    QVector<Line> lines;
+    bool editable = false;
+
+    double totalPrice = 0;
+    double discountRate = 0;
+    double payable = 0;
+};
+
+#endif //HTTP_CLIENT_CARTMODEL_H
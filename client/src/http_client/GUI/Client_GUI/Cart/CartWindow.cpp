@@ -1,18 +1,17 @@
 #include "CartWindow.h"
 #include "http_client/GUI/Login_GUI/UserSession.h"
 #include "http_client/GUI/Client_GUI/MainWindow.h"
+#include "http_client/http_requests/CartOperationQueue.h"
 #include <QMessageBox>
-#include <QStandardItem>
 #include <QHeaderView>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QTimer>
 
-#include <QPrinter>
-#include <QPrintDialog>
-#include <QPainter>
 #include <QFileDialog>
+#include "http_client/GUI/Client_GUI/Reports/ReportEngine.h"
 
-CartWindow::CartWindow(Requests* requests, QWidget *parent) : QWidget(parent), ui(new Ui::Form_cart), model(new QStandardItemModel(this)), requests(requests)
+CartWindow::CartWindow(Requests* requests, CartOperationQueue *queue, QWidget *parent) : QWidget(parent), ui(new Ui::Form_cart), model(new CartModel(&DiscountTable::shared(), this)), requests(requests), queue(queue)
 {
     ui->setupUi(this);
 
@@ -21,6 +20,21 @@ CartWindow::CartWindow(Requests* requests, QWidget *parent) : QWidget(parent), u
     ui->tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
     ui->tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
+    // Количество меняется прямо в таблице: изменение сразу видно в строке и итогах,
+    // а на сервер уходит через общую очередь вместе с нажатиями в каталоге
+    if (queue)
+    {
+        model->setEditable(true);
+        ui->tableView->setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed);
+        connect(model, &CartModel::quantityChangeRequested, queue, &CartOperationQueue::add);
+        connect(queue, &CartOperationQueue::pendingChanged, this, [this]() {
+            // Итог считается по локальной копии ступеней: перед пересчётом проверяем, не устарела ли она
+            DiscountTable::shared().refresh(this->requests);
+            model->setPending(this->queue->pending());
+        });
+        model->setPending(queue->pending());
+    }
+
     MainWindow* mainWindow = qobject_cast<MainWindow*>(parent);
 
     if (mainWindow)
@@ -30,10 +44,37 @@ CartWindow::CartWindow(Requests* requests, QWidget *parent) : QWidget(parent), u
     connect(ui->pushButton_order_2, &QPushButton::clicked, this, &CartWindow::onClearClicked);
     connect(ui->pushButton_exit, &QPushButton::clicked, this, &CartWindow::onExitClicked);
 
+    // Обновления корзины приходят пачками (открытие окна, cartUpdated, добавление товара):
+    // все запросы внутри окна сливаются в одну загрузку
+    reloadTimer = new QTimer(this);
+    reloadTimer->setSingleShot(true);
+    reloadTimer->setInterval(CartReloadDelayMs);
+    connect(reloadTimer, &QTimer::timeout, this, &CartWindow::fetchCart);
+
+    // Без ступеней скидок итоги показываются только по ответам сервера
+    connect(&DiscountTable::shared(), &DiscountTable::changed, model, &CartModel::refreshTotals);
+    DiscountTable::shared().refresh(requests);
+
     loadCart();
 }
 
 void CartWindow::loadCart()
+{
+    // Таймер не перезапускается, чтобы непрерывный поток обновлений не откладывал загрузку бесконечно
+    if (!reloadTimer->isActive())
+    {
+        reloadTimer->start();
+    }
+}
+
+void CartWindow::showCart(const Dto::Cart &cart)
+{
+    // Запланированная загрузка вернула бы то же самое
+    reloadTimer->stop();
+    model->setServerCart(cart);
+}
+
+void CartWindow::fetchCart()
 {
     int customerId = UserSession::instance().getCustomerId();
     if (customerId <= 0)
@@ -42,144 +83,111 @@ void CartWindow::loadCart()
         return;
     }
 
-    QJsonObject cartData = requests->getCart(customerId);
-    if (cartData.isEmpty())
-    {
-        QMessageBox::information(this, "Корзина", "Не удалось загрузить корзину");
-        return;
-    }
+    requests->getCartAsync(customerId, this, [this](bool ok, const Dto::Cart &cart) {
+        if (!ok)
+        {
+            QMessageBox::information(this, "Корзина", "Не удалось загрузить корзину");
+            return;
+        }
+
+        model->setServerCart(cart);
+        ui->tableView->resizeColumnsToContents();
+        if (cart.items.isEmpty())
+        {
+            QMessageBox::information(this, "Корзина", "Корзина пуста");
+        }
+    });
+}
 
-    if (cartData["items"].toArray().isEmpty())
+void CartWindow::onOrderClicked()
+{
+    int customerId = UserSession::instance().getCustomerId();
+    if (customerId <= 0)
     {
-        QMessageBox::information(this, "Корзина", "Корзина пуста");
-        model->clear();
+        QMessageBox::warning(this, "Ошибка", "Пользователь не авторизован");
         return;
     }
 
-    populateTable(cartData);
+    // Повторное нажатие до ответа сервера оформило бы заказ дважды
+    ui->pushButton_order->setEnabled(false);
+    placeOrderWhenSaved(customerId);
 }
 
-
-void CartWindow::populateTable(const QJsonObject &cartData)
+void CartWindow::placeOrderWhenSaved(int customerId)
 {
-    model->clear();
-    model->setHorizontalHeaderLabels({"Товар", "Кол-во", "Цена", "Сумма"});
-
-    QJsonArray items = cartData["items"].toArray();
-    double totalPrice = cartData["total_price"].toDouble();
-    double discountedPrice = cartData["discounted_price"].toDouble();
-    double discountRate = cartData["discount_rate"].toDouble() * 100;
-
-    for (const QJsonValue &val : items)
+    // Заказ оформляется по корзине сервера: несохранённые изменения количества сначала отправляются.
+    // Изменения, накопленные, пока пакет был в пути, уходят следующим пакетом, поэтому проверка повторяется
+    if (!queue || queue->isIdle())
     {
-        QJsonObject obj = val.toObject();
-        double price = obj["Price"].toDouble();
-        int quantity = obj["Quantity"].toInt();
-        double sum = price * quantity;
-
-        QList<QStandardItem*> row;
-        row << new QStandardItem(obj["ProductName"].toString());
-        row << new QStandardItem(QString::number(quantity));
-        row << new QStandardItem(QString::number(price, 'f', 2));
-        row << new QStandardItem(QString::number(sum, 'f', 2));
-        model->appendRow(row);
+        placeOrder(customerId);
+        return;
     }
 
-    QList<QStandardItem*> totalRow;
-    totalRow << new QStandardItem("Итого:");
-    totalRow << new QStandardItem("");
-    totalRow << new QStandardItem("");
-    totalRow << new QStandardItem(QString::number(totalPrice, 'f', 2));
-
-    QList<QStandardItem*> discountRow;
-    discountRow << new QStandardItem(QString("Скидка (%1%)").arg(discountRate, 0, 'f', 1));
-    discountRow << new QStandardItem("");
-    discountRow << new QStandardItem("");
-    discountRow << new QStandardItem(QString("-%1").arg(totalPrice - discountedPrice, 0, 'f', 2));
-
-    QList<QStandardItem*> finalRow;
-    finalRow << new QStandardItem("К оплате:");
-    finalRow << new QStandardItem("");
-    finalRow << new QStandardItem("");
-    finalRow << new QStandardItem(QString::number(discountedPrice, 'f', 2));
-
-    QFont boldFont;
-    boldFont.setBold(true);
-    for (auto item : totalRow + discountRow + finalRow)
-    {
-        item->setFont(boldFont);
-        if (item->text().startsWith("К оплате:"))
+    whenBatchAnswered([this, customerId](bool ok) {
+        if (ok)
         {
-            item->setForeground(QBrush(Qt::blue));
+            placeOrderWhenSaved(customerId);
+            return;
         }
-    }
-
-    model->appendRow(totalRow);
-    model->appendRow(discountRow);
-    model->appendRow(finalRow);
-    ui->tableView->resizeColumnsToContents();
+        ui->pushButton_order->setEnabled(true);
+        QMessageBox::warning(this, "Ошибка", "Не удалось сохранить изменения корзины");
+    });
+    queue->flush();
 }
 
-void CartWindow::onOrderClicked()
+void CartWindow::whenBatchAnswered(const std::function<void(bool)> &next)
 {
-    int customerId = UserSession::instance().getCustomerId();
-    if (customerId <= 0)
-    {
-        QMessageBox::warning(this, "Ошибка", "Пользователь не авторизован");
-        return;
-    }
+    // Подписки одноразовые: держатель удаляется вместе с ними, а при закрытии окна - вместе с окном
+    auto *waiter = new QObject(this);
+    auto answered = [this, waiter, next](bool ok) {
+        disconnect(queue, nullptr, waiter, nullptr);
+        waiter->deleteLater();
+        next(ok);
+    };
+    connect(queue, &CartOperationQueue::flushed, waiter, [answered]() { answered(true); });
+    connect(queue, &CartOperationQueue::failed, waiter, [answered]() { answered(false); });
+}
 
+void CartWindow::placeOrder(int customerId)
+{
     QJsonObject orderData;
     orderData["employee_id"] = 1;
     orderData["is_wholesale"] = false;
 
-    QJsonObject response = requests->placeOrder(customerId, orderData);
+    requests->placeOrderAsync(customerId, orderData, this, [this](bool ok, const Dto::Transaction &order) {
+        ui->pushButton_order->setEnabled(true);
 
-    if (response.isEmpty() || !response.contains("TransactionID") || !response.contains("details"))
-    {
-        QMessageBox::warning(this, "Ошибка", "Некорректный ответ от сервера.");
-        return;
-    }
+        if (!ok || order.id <= 0)
+        {
+            QMessageBox::warning(this, "Ошибка", "Некорректный ответ от сервера.");
+            return;
+        }
 
-    generatePdfReport(response);
+        generatePdfReport(order);
 
-    QMessageBox::information(this, "Успешно",
-                             QString("Заказ #%1 успешно оформлен!").arg(response["TransactionID"].toInt()));
+        QMessageBox::information(this, "Успешно",
+                                 QString("Заказ #%1 успешно оформлен!").arg(order.id));
 
-    loadCart();
+        loadCart();
+    });
 }
 
 
-void CartWindow::generatePdfReport(const QJsonObject &orderData)
+void CartWindow::generatePdfReport(const Dto::Transaction &order)
 {
-    QPrinter printer(QPrinter::HighResolution);
-    printer.setOutputFormat(QPrinter::PdfFormat);
-    QString fileName = QFileDialog::getSaveFileName(this, "Сохранить отчёт", "", "PDF Files (*.pdf)");
+    QString fileName = QFileDialog::getSaveFileName(this, "Сохранить отчёт", QString("Заказ_%1.pdf").arg(order.id),
+                                                    "PDF Files (*.pdf)");
     if (fileName.isEmpty()) return;
-    printer.setOutputFileName(fileName);
-    QPainter painter;
-    if (!painter.begin(&printer))
-    {
-        QMessageBox::warning(this, "Ошибка", "Не удалось создать PDF");
-        return;
-    }
-    QFont headerFont;
-    headerFont.setPointSize(16);
-    headerFont.setBold(true);
-    QFont normalFont;
-    normalFont.setPointSize(14);
-    const int leftMargin = 150;
-    painter.setFont(headerFont);
-    painter.drawText(leftMargin, 100, "ОТЧЁТ О ЗАКАЗЕ");
-    painter.setFont(normalFont);
-    painter.drawText(leftMargin, 300, QString("Номер заказа: #%1").arg(orderData["TransactionID"].toInt()));
-    painter.drawText(leftMargin, 600, QString("Дата: %1").arg(orderData["TransactionDate"].toString()));
-    painter.drawText(leftMargin, 900, QString("Тип: %1").arg(orderData["IsWholesale"].toBool() ? "Оптовый" : "Розничный"));
-    painter.drawText(leftMargin, 1200, QString("Сумма: %1 ₽").arg(orderData["total_amount"].toDouble(), 0, 'f', 2));
-    painter.drawText(leftMargin, 1500, QString("Скидка: %1 ₽").arg(orderData["discount_amount"].toDouble(), 0, 'f', 2));
-    painter.drawText(leftMargin, 1800, QString("Итого к оплате: %1 ₽").arg( orderData["total_amount"].toDouble() - orderData["discount_amount"].toDouble(), 0, 'f', 2));
-    painter.end();
-    QMessageBox::information(this, "Готово", "PDF отчёт успешно создан");
+
+    // Отчёт рисуется в фоне, окно корзины остаётся отзывчивым
+    ReportEngine::shared().exportOrders({order}, fileName, this, [this](bool ok) {
+        if (!ok)
+        {
+            QMessageBox::warning(this, "Ошибка", "Не удалось создать PDF");
+            return;
+        }
+        QMessageBox::information(this, "Готово", "PDF отчёт успешно создан");
+    });
 }
 
 void CartWindow::onClearClicked()
@@ -191,23 +199,46 @@ void CartWindow::onClearClicked()
         return;
     }
 
-    QJsonObject response = requests->clearCart(customerId);
-    if (response.isEmpty())
-    {
-        QMessageBox::warning(this, "Ошибка", "Не удалось очистить корзину");
-        return;
-    }
+    // Неотправленные изменения отброшены; пакет, который уже в пути, мог бы дойти до сервера после
+    // очистки и вернуть товары в корзину, поэтому очистка отправляется после ответа на него
+    ui->pushButton_order_2->setEnabled(false);
+    clearWhenSent(customerId);
+}
 
-    if (response.contains("message"))
-    {
-        QMessageBox::information(this, "Успешно", "Корзина очищена!");
-        loadCart();
-    }
-    else
+void CartWindow::clearWhenSent(int customerId)
+{
+    if (queue)
     {
-        QMessageBox::warning(this, "Ошибка",
-                             response.contains("error") ? response["error"].toString() : "Неизвестная ошибка");
+        queue->clear();
+        if (queue->isSending())
+        {
+            whenBatchAnswered([this, customerId](bool) {
+                clearWhenSent(customerId);
+            });
+            return;
+        }
     }
+
+    requests->clearCartAsync(customerId, this, [this](const QJsonObject &response) {
+        ui->pushButton_order_2->setEnabled(true);
+
+        if (response.isEmpty())
+        {
+            QMessageBox::warning(this, "Ошибка", "Не удалось очистить корзину");
+            return;
+        }
+
+        if (response.contains("message"))
+        {
+            QMessageBox::information(this, "Успешно", "Корзина очищена!");
+            loadCart();
+        }
+        else
+        {
+            QMessageBox::warning(this, "Ошибка",
+                                 response.contains("error") ? response["error"].toString() : "Неизвестная ошибка");
+        }
+    });
 }
 
 void CartWindow::onExitClicked()
@@ -2,38 +2,57 @@
 #define CARTWINDOW_H
 
 #include <QWidget>
-#include <QStandardItemModel>
+#include <functional>
 #include <QJsonObject>
 #include "ui_FormCart.h"
 #include "http_client/http_requests/Requests.h"
+#include "CartModel.h"
+#include "DiscountTable.h"
 
 namespace Ui {
     class Form_cart;
 }
 
 class MainWindow;
+class CartOperationQueue;
+class QTimer;
 
 class CartWindow : public QWidget
 {
 Q_OBJECT
 
 public:
-    explicit CartWindow(Requests* requests, QWidget *parent = nullptr);
-    void loadCart();
+    // queue - общая с каталогом очередь изменений корзины; nullptr - количество не редактируется
+    explicit CartWindow(Requests* requests, CartOperationQueue *queue = nullptr, QWidget *parent = nullptr);
     ~CartWindow();
 
+public slots:
+    // Запланировать обновление корзины; несколько вызовов подряд дают одну загрузку
+    void loadCart();
+    // Показать готовое содержимое корзины (из события сервера) без запроса
+    void showCart(const Dto::Cart &cart);
+
 private slots:
+    void fetchCart();
     void onOrderClicked();
     void onClearClicked();
     void onExitClicked();
 
 private:
-    void populateTable(const QJsonObject &cartData);
-    void generatePdfReport(const QJsonObject &orderData);
+    // next вызывается один раз, когда очередь ответит на отправленный пакет (true - принят)
+    void whenBatchAnswered(const std::function<void(bool)> &next);
+    void placeOrderWhenSaved(int customerId);
+    void placeOrder(int customerId);
+    void clearWhenSent(int customerId);
+    void generatePdfReport(const Dto::Transaction &order);
 
     Ui::Form_cart *ui;
-    QStandardItemModel *model;
+    CartModel *model;
     Requests* requests;
+    CartOperationQueue *queue;
+    QTimer *reloadTimer;
+
+    static const int CartReloadDelayMs = 50;
 };
 
 #endif // CARTWINDOW_H
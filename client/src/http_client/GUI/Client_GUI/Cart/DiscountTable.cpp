@@ -0,0 +1,123 @@
+#include "DiscountTable.h"
+#include <QCoreApplication>
+#include <QPointer>
+#include <algorithm>
+#include "http_client/http_requests/Requests.h"
+
+DiscountTable::DiscountTable(QObject *parent) : QObject(parent)
+{
+}
+
+DiscountTable &DiscountTable::shared()
+{
+    static QPointer<DiscountTable> instance;
+    if (!instance)
+    {
+        instance = new DiscountTable(QCoreApplication::instance());
+    }
+    return *instance;
+}
+
+static bool isBetter(const Dto::Discount &discount, const Dto::Discount *current)
+{
+    // Наибольшая ставка; при равной - меньший номер, как на сервере
+    return !current || discount.rate > current->rate ||
+           (discount.rate == current->rate && discount.id < current->id);
+}
+
+void DiscountTable::setDiscounts(const QVector<Dto::Discount> &list)
+{
+    discounts = list;
+    loaded = true;
+
+    // Индекс строится один раз на изменение таблицы, поиск - два бинарных поиска.
+    // Ступеней единицы, поэтому квадратичная сборка не заметна
+    bounds.clear();
+    for (const Dto::Discount &discount : discounts)
+    {
+        bounds.append(discount.minQuantity);
+        bounds.append(discount.maxQuantity + 1);
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    segments.clear();
+    segments.reserve(bounds.size());
+    for (int start : bounds)
+    {
+        QVector<int> active;
+        for (int i = 0; i < discounts.size(); ++i)
+        {
+            if (discounts.at(i).minQuantity <= start && start <= discounts.at(i).maxQuantity)
+            {
+                active.append(i);
+            }
+        }
+        std::sort(active.begin(), active.end(), [this](int a, int b) {
+            return discounts.at(a).minTotalPrice < discounts.at(b).minTotalPrice;
+        });
+
+        Segment segment;
+        const Dto::Discount *current = nullptr;
+        int currentIndex = -1;
+        for (int i : active)
+        {
+            if (isBetter(discounts.at(i), current))
+            {
+                current = &discounts.at(i);
+                currentIndex = i;
+            }
+            segment.prices.append(discounts.at(i).minTotalPrice);
+            segment.best.append(currentIndex);
+        }
+        segments.append(segment);
+    }
+}
+
+void DiscountTable::refresh(Requests *requests)
+{
+    if (refreshing || (loaded && checkedAt.isValid() && checkedAt.elapsed() < MaxAgeMs))
+    {
+        return;
+    }
+
+    refreshing = true;
+    requests->getDiscountsAsync(version, this, [this](bool ok, bool isChanged, const QString &newVersion,
+                                                      const Dto::DiscountsList &list) {
+        refreshing = false;
+        if (!ok)
+        {
+            return;
+        }
+
+        checkedAt.start();
+        if (isChanged)
+        {
+            version = newVersion;
+            setDiscounts(list.discounts);
+            emit changed();
+        }
+    });
+}
+
+const Dto::Discount *DiscountTable::find(int totalItems, double totalPrice) const
+{
+    if (totalItems == 0 || totalPrice == 0.0)
+    {
+        return nullptr;
+    }
+
+    const auto bound = std::upper_bound(bounds.constBegin(), bounds.constEnd(), totalItems);
+    if (bound == bounds.constBegin())
+    {
+        return nullptr;
+    }
+    const Segment &segment = segments.at(int(bound - bounds.constBegin()) - 1);
+
+    const auto price = std::upper_bound(segment.prices.constBegin(), segment.prices.constEnd(), totalPrice);
+    if (price == segment.prices.constBegin())
+    {
+        return nullptr;
+    }
+    return &discounts.at(segment.best.at(int(price - segment.prices.constBegin()) - 1));
+}
@@ -0,0 +1,57 @@
+#ifndef HTTP_CLIENT_DISCOUNTTABLE_H
+#define HTTP_CLIENT_DISCOUNTTABLE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QVector>
+#include "http_client/http_requests/Dto.h"
+
+class Requests;
+
+// Ступени скидок с сервера (/discounts). Выбор ступени повторяет crud.calculate_discount,
+// поэтому корзина считает итог со скидкой сама, не дожидаясь ответа сервера.
+// Таблица одна на приложение: окна корзины не скачивают её заново, а перепроверяют по ETag, когда копия устарела
+class DiscountTable : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DiscountTable &shared();
+
+    void setDiscounts(const QVector<Dto::Discount> &discounts);
+    bool isLoaded() const { return loaded; }
+
+    // Перепроверить ступени на сервере, если копия старше MaxAgeMs; при изменении придёт changed()
+    void refresh(Requests *requests);
+
+    // Ступень с наибольшей ставкой среди подходящих; nullptr - скидки нет
+    const Dto::Discount *find(int totalItems, double totalPrice) const;
+
+signals:
+    void changed();
+
+private:
+    explicit DiscountTable(QObject *parent = nullptr);
+
+    // Отрезок количества [start, следующая граница) с постоянным набором подходящих ступеней:
+    // пороги суммы по возрастанию и лучшая ступень среди порогов не больше текущего
+    struct Segment
+    {
+        QVector<double> prices;
+        QVector<int> best; // индексы в discounts
+    };
+
+    QVector<Dto::Discount> discounts;
+    QVector<int> bounds;
+    QVector<Segment> segments;
+    bool loaded = false;
+
+    QString version;
+    QElapsedTimer checkedAt;
+    bool refreshing = false;
+
+    // Как max-age ответа /discounts
+    static const int MaxAgeMs = 300000;
+};
+
+#endif //HTTP_CLIENT_DISCOUNTTABLE_H
@@ -0,0 +1,226 @@
+#include "CatalogSnapshot.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDebug>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace
+{
+    const quint32 Magic = 0x43534E50; // "CSNP"
+    const quint32 FormatVersion = 2;
+    const int ThumbnailQuality = 85;
+    // Меньше на товар в файле не бывает (номер и две цены); защищает от битого счётчика
+    const int MinProductBytes = 4 + 8 + 8;
+
+    QByteArray encodeThumbnail(const QImage &image)
+    {
+        // Фотографии без прозрачности в JPEG в разы меньше, чем в PNG
+        QByteArray data;
+        if (!image.hasAlphaChannel()) {
+            QBuffer buffer(&data);
+            if (buffer.open(QIODevice::WriteOnly) && image.save(&buffer, "JPG", ThumbnailQuality)) {
+                return data;
+            }
+            data.clear();
+        }
+
+        QBuffer buffer(&data);
+        if (!buffer.open(QIODevice::WriteOnly) || !image.save(&buffer, "PNG")) {
+            return QByteArray();
+        }
+        return data;
+    }
+}
+
+CatalogSnapshot::~CatalogSnapshot()
+{
+    close();
+}
+
+QString CatalogSnapshot::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/catalog.snapshot";
+}
+
+bool CatalogSnapshot::open(const QString &path, bool readProducts)
+{
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    mappedSize = file.size();
+    mapped = file.map(0, mappedSize);
+    if (!mapped || !parse(readProducts)) {
+        qDebug() << "Снимок каталога повреждён или недоступен:" << path;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void CatalogSnapshot::close()
+{
+    products.clear();
+    thumbnails.clear();
+    catalogVersion.clear();
+
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    mappedSize = 0;
+    file.close();
+}
+
+bool CatalogSnapshot::parse(bool readProducts)
+{
+    if (mappedSize < qint64(sizeof(qint64))) {
+        return false;
+    }
+
+    // Заголовок и товары читаются через файл, а не через QByteArray поверх отображения:
+    // у QByteArray размер int, и снимок больше 2 ГБ иначе не открылся бы
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0;
+    quint32 format = 0;
+    in >> magic >> format;
+    if (magic != Magic || format != FormatVersion) {
+        return false;
+    }
+
+    qint32 size = 0;
+    qint32 count = 0;
+    in >> catalogVersion >> size >> count;
+    if (in.status() != QDataStream::Ok || count < 0 || qint64(count) * MinProductBytes > mappedSize) {
+        return false;
+    }
+    imageSize = size;
+
+    if (readProducts) {
+        products.resize(count);
+        for (Dto::Product &product : products) {
+            qint32 id = 0;
+            in >> id >> product.wholesalePrice >> product.retailPrice >> product.name >> product.description >> product.imageHash;
+            product.id = id;
+        }
+    }
+
+    qint64 indexOffset = -1;
+    file.seek(mappedSize - qint64(sizeof(qint64)));
+    in >> indexOffset;
+    if (indexOffset < 0 || indexOffset > mappedSize - qint64(sizeof(qint64))) {
+        return false;
+    }
+
+    file.seek(indexOffset);
+    qint32 thumbnailCount = 0;
+    in >> thumbnailCount;
+    for (int i = 0; i < thumbnailCount && in.status() == QDataStream::Ok; ++i) {
+        qint32 productId = 0;
+        quint32 imageHash = 0;
+        ThumbnailEntry entry{};
+        in >> productId >> imageHash >> entry.offset >> entry.length;
+
+        const bool valid = entry.length > 0 && entry.offset >= 0 && entry.offset + entry.length <= indexOffset;
+        if (!valid) {
+            return false;
+        }
+        thumbnails.insert(ThumbnailKey{productId, imageHash}, entry);
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+QByteArray CatalogSnapshot::thumbnail(const ThumbnailKey &key) const
+{
+    auto it = thumbnails.constFind(key);
+    if (it == thumbnails.constEnd()) {
+        return QByteArray();
+    }
+
+    // Копия, а не fromRawData: декодирование идёт в другом потоке и может пережить отображение
+    const ThumbnailEntry &entry = it.value();
+    return QByteArray(reinterpret_cast<const char *>(mapped + entry.offset), entry.length);
+}
+
+bool CatalogSnapshot::save(const QString &path, const QString &version, const ProductStore &store, int thumbnailSize,
+                           const QHash<ThumbnailKey, QImage> &decoded)
+{
+    // Прежний снимок открывается своим экземпляром: отображение в GUI-потоке к этому моменту закрыто
+    CatalogSnapshot previous;
+    const bool hasPrevious = previous.open(path, false) && previous.thumbnailSize() == thumbnailSize;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    const bool written = write(&file, version, store, thumbnailSize, decoded, hasPrevious ? &previous : nullptr);
+    // Открытый файл нельзя заменить на Windows, поэтому прежний снимок закрывается до commit()
+    previous.close();
+    if (!written) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool CatalogSnapshot::write(QIODevice *device, const QString &version, const ProductStore &store, int thumbnailSize,
+                            const QHash<ThumbnailKey, QImage> &decoded, const CatalogSnapshot *previous)
+{
+    QDataStream out(device);
+    out.setVersion(QDataStream::Qt_5_12);
+
+    out << Magic << FormatVersion << version << qint32(thumbnailSize) << qint32(store.size());
+    for (int row = 0; row < store.size(); ++row) {
+        out << qint32(store.id(row)) << store.wholesalePrice(row) << store.retailPrice(row)
+            << store.name(row) << store.description(row) << store.imageHash(row);
+    }
+
+    struct IndexItem
+    {
+        ThumbnailKey key;
+        ThumbnailEntry entry;
+    };
+    QVector<IndexItem> index;
+
+    for (int row = 0; row < store.size(); ++row) {
+        if (!store.hasImage(row)) {
+            continue;
+        }
+
+        const ThumbnailKey key{store.id(row), store.imageKey(row)};
+        QByteArray data = previous ? previous->thumbnail(key) : QByteArray();
+        if (data.isEmpty()) {
+            const QImage image = decoded.value(key);
+            if (image.isNull()) {
+                continue;
+            }
+            data = encodeThumbnail(image);
+            if (data.isEmpty()) {
+                continue;
+            }
+        }
+
+        const qint64 offset = device->pos();
+        if (device->write(data) != data.size()) {
+            return false;
+        }
+        index.append({key, {offset, qint32(data.size())}});
+    }
+
+    const qint64 indexOffset = device->pos();
+    out << qint32(index.size());
+    for (const IndexItem &item : index) {
+        out << qint32(item.key.productId) << quint32(item.key.imageHash) << item.entry.offset << item.entry.length;
+    }
+    out << indexOffset;
+
+    return out.status() == QDataStream::Ok;
+}
@@ -0,0 +1,69 @@
+#ifndef HTTP_CLIENT_CATALOGSNAPSHOT_H
+#define HTTP_CLIENT_CATALOGSNAPSHOT_H
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QVector>
+#include "ProductStore.h"
+#include "ThumbnailCache.h"
+
+class QIODevice;
+
+// Сохранённая на диске копия каталога: товары и миниатюры нужного размера.
+// Миниатюры хранятся сжатыми (JPEG, с прозрачностью - PNG) и берутся прямо из отображения
+// файла в память (QFile::map); декодирует их пул потоков ThumbnailCache. Формат:
+//   заголовок (сигнатура, версия формата, версия каталога, размер миниатюр), товары,
+//   сжатые миниатюры, индекс миниатюр, смещение индекса (последние 8 байт). Смещения 64-битные.
+class CatalogSnapshot
+{
+public:
+    CatalogSnapshot() = default;
+    ~CatalogSnapshot();
+    CatalogSnapshot(const CatalogSnapshot &) = delete;
+    CatalogSnapshot &operator=(const CatalogSnapshot &) = delete;
+
+    static QString defaultPath();
+
+    // readProducts = false - только миниатюры (снимок, переоткрытый после записи)
+    bool open(const QString &path, bool readProducts = true);
+    void close();
+    bool isOpen() const { return mapped != nullptr; }
+
+    // Версия каталога на сервере (/products/version), которой соответствует снимок
+    const QString &version() const { return catalogVersion; }
+    int thumbnailSize() const { return imageSize; }
+    // Товары читаются один раз при открытии и отдаются владельцу
+    QVector<Dto::Product> takeProducts() { return std::move(products); }
+    bool hasThumbnail(const ThumbnailKey &key) const { return thumbnails.contains(key); }
+    // Сжатая миниатюра, скопированная из файла; пустой массив, если её в снимке нет
+    QByteArray thumbnail(const ThumbnailKey &key) const;
+
+    // Записывает снимок через QSaveFile; вызывается в рабочем потоке. store - копия каталога,
+    // decoded - миниатюры из памяти. Миниатюры, которые уже есть в прежнем файле по этому пути,
+    // переносятся как есть, без повторного сжатия. Прежний файл не должен быть открыт в другом месте
+    static bool save(const QString &path, const QString &version, const ProductStore &store, int thumbnailSize,
+                     const QHash<ThumbnailKey, QImage> &decoded);
+
+private:
+    struct ThumbnailEntry
+    {
+        qint64 offset;
+        qint32 length;
+    };
+
+    bool parse(bool readProducts);
+    static bool write(QIODevice *device, const QString &version, const ProductStore &store, int thumbnailSize,
+                      const QHash<ThumbnailKey, QImage> &decoded, const CatalogSnapshot *previous);
+
+    QFile file;
+    uchar *mapped = nullptr;
+    qint64 mappedSize = 0;
+
+    QString catalogVersion;
+    int imageSize = 0;
+    QVector<Dto::Product> products;
+    QHash<ThumbnailKey, ThumbnailEntry> thumbnails;
+};
+
+#endif //HTTP_CLIENT_CATALOGSNAPSHOT_H
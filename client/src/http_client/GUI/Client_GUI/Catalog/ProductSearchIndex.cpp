@@ -0,0 +1,256 @@
+#include "ProductSearchIndex.h"
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    quint64 trigramKey(const QString &text, int pos)
+    {
+        return (quint64(text[pos].unicode()) << 32) | (quint64(text[pos + 1].unicode()) << 16) | text[pos + 2].unicode();
+    }
+
+    bool hasWordPrefix(const QString &text, const QString &term)
+    {
+        for (int pos = text.indexOf(term); pos >= 0; pos = text.indexOf(term, pos + 1)) {
+            if (pos == 0 || !text[pos - 1].isLetterOrNumber()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    QVector<int> intersect(const QVector<int> &a, const QVector<int> &b)
+    {
+        QVector<int> result;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+        return result;
+    }
+}
+
+ProductSearchIndex::ProductSearchIndex(ProductTableModel *model, QObject *parent) : QObject(parent), model(model)
+{
+    connect(model, &QAbstractItemModel::modelReset, this, &ProductSearchIndex::rebuild);
+    connect(model, &QAbstractItemModel::rowsInserted, this, &ProductSearchIndex::addRows);
+    // Изменённые и удалённые строки сдвигают номера, поэтому индекс строится заново
+    connect(model, &ProductTableModel::catalogPatched, this, &ProductSearchIndex::rebuild);
+    rebuild();
+}
+
+void ProductSearchIndex::rebuild()
+{
+    tokens.clear();
+    sortedTokens.clear();
+    trigrams.clear();
+    lastQuery.clear();
+    lastRows.clear();
+
+    if (model->products().size() > 0) {
+        addRows(QModelIndex(), 0, model->products().size() - 1);
+    }
+}
+
+void ProductSearchIndex::addRows(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    const ProductStore &store = model->products();
+    for (int row = first; row <= last; ++row) {
+        addText(folded(store.nameRef(row)), row, true);
+        addText(folded(store.descriptionRef(row)), row, false);
+        addToken(QString::number(store.id(row)), row);
+        addToken(QString::number(store.wholesalePrice(row), 'f', 2), row);
+        addToken(QString::number(store.retailPrice(row), 'f', 2), row);
+    }
+
+    sortedTokens.clear();
+    // Новые строки могли попасть в результаты прошлого запроса, уточнять его больше нельзя
+    lastQuery.clear();
+    lastRows.clear();
+}
+
+const QString &ProductSearchIndex::folded(int stringRef)
+{
+    // Пул сжался и перенумеровал строки: прежние индексы указывают на другие строки
+    const int version = model->products().stringsVersion();
+    if (version != foldedVersion) {
+        foldedStrings.clear();
+        foldedVersion = version;
+    }
+
+    if (stringRef >= foldedStrings.size()) {
+        foldedStrings.resize(stringRef + 1);
+    }
+
+    QString &value = foldedStrings[stringRef];
+    if (value.isNull()) {
+        value = model->products().string(stringRef).toCaseFolded();
+        if (value.isNull()) {
+            value = QLatin1String("");
+        }
+    }
+    return value;
+}
+
+void ProductSearchIndex::addToken(const QString &token, int row)
+{
+    QVector<int> &rows = tokens[token];
+    // Строки добавляются по возрастанию, поэтому достаточно проверить последний элемент
+    if (rows.isEmpty() || rows.last() != row) {
+        rows.append(row);
+    }
+}
+
+void ProductSearchIndex::addText(const QString &text, int row, bool withTrigrams)
+{
+    int start = -1;
+    for (int i = 0; i <= text.size(); ++i) {
+        const bool letter = i < text.size() && text[i].isLetterOrNumber();
+        if (letter && start < 0) {
+            start = i;
+        } else if (!letter && start >= 0) {
+            addToken(text.mid(start, i - start), row);
+            start = -1;
+        }
+    }
+
+    if (!withTrigrams) {
+        return;
+    }
+
+    for (int pos = 0; pos + 3 <= text.size(); ++pos) {
+        QVector<int> &rows = trigrams[trigramKey(text, pos)];
+        if (rows.isEmpty() || rows.last() != row) {
+            rows.append(row);
+        }
+    }
+}
+
+QVector<int> ProductSearchIndex::tokenPrefixRows(const QString &prefix)
+{
+    if (sortedTokens.isEmpty() && !tokens.isEmpty()) {
+        sortedTokens = tokens.keys();
+        std::sort(sortedTokens.begin(), sortedTokens.end());
+    }
+
+    QVector<int> rows;
+    for (auto it = std::lower_bound(sortedTokens.cbegin(), sortedTokens.cend(), prefix);
+         it != sortedTokens.cend() && it->startsWith(prefix); ++it) {
+        rows += tokens.value(*it);
+    }
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+QVector<int> ProductSearchIndex::trigramRows(const QString &term) const
+{
+    QVector<const QVector<int> *> lists;
+    for (int pos = 0; pos + 3 <= term.size(); ++pos) {
+        auto it = trigrams.constFind(trigramKey(term, pos));
+        if (it == trigrams.constEnd()) {
+            return QVector<int>();
+        }
+        lists.append(&it.value());
+    }
+
+    // Пересечение начинаем с самого короткого списка
+    std::sort(lists.begin(), lists.end(), [](const QVector<int> *a, const QVector<int> *b) { return a->size() < b->size(); });
+    QVector<int> rows = *lists.first();
+    for (int i = 1; i < lists.size() && !rows.isEmpty(); ++i) {
+        rows = intersect(rows, *lists[i]);
+    }
+    return rows;
+}
+
+QVector<int> ProductSearchIndex::termRows(const QString &term)
+{
+    QVector<int> rows = tokenPrefixRows(term);
+    if (term.size() >= 3) {
+        QVector<int> substringRows = trigramRows(term);
+        QVector<int> merged;
+        std::set_union(rows.begin(), rows.end(), substringRows.begin(), substringRows.end(), std::back_inserter(merged));
+        rows = merged;
+    }
+    return rows;
+}
+
+int ProductSearchIndex::score(int row, const QStringList &terms)
+{
+    const ProductStore &store = model->products();
+    const QString &name = folded(store.nameRef(row));
+    const QString &description = folded(store.descriptionRef(row));
+
+    int total = 0;
+    for (const QString &term : terms) {
+        int termScore = 0;
+        if (QString::number(store.id(row)) == term) {
+            termScore = 1000;
+        } else if (name.startsWith(term)) {
+            termScore = 100;
+        } else if (hasWordPrefix(name, term)) {
+            termScore = 60;
+        } else if (name.contains(term)) {
+            termScore = 30;
+        } else if (QString::number(store.retailPrice(row), 'f', 2).startsWith(term) ||
+                   QString::number(store.wholesalePrice(row), 'f', 2).startsWith(term) ||
+                   QString::number(store.id(row)).startsWith(term)) {
+            termScore = 20;
+        } else if (hasWordPrefix(description, term)) {
+            termScore = 10;
+        }
+
+        // Все слова запроса должны найтись в товаре
+        if (termScore == 0) {
+            return 0;
+        }
+        total += termScore;
+    }
+    return total;
+}
+
+QVector<ProductSearchIndex::Match> ProductSearchIndex::search(const QString &query)
+{
+    const QString normalized = query.toCaseFolded().simplified().replace(',', '.');
+    const QStringList terms = normalized.split(' ', Qt::SkipEmptyParts);
+    if (terms.isEmpty()) {
+        lastQuery.clear();
+        lastRows.clear();
+        return QVector<Match>();
+    }
+
+    // Запрос дописывается: новые совпадения - подмножество прошлых, индекс не нужен.
+    // Для слов короче трёх символов подстроки в названиях не искались, поэтому там уточнять нельзя
+    bool refine = !lastQuery.isEmpty() && normalized.startsWith(lastQuery);
+    for (const QString &term : lastQuery.split(' ', Qt::SkipEmptyParts)) {
+        refine = refine && term.size() >= 3;
+    }
+
+    QVector<int> candidates;
+    if (refine) {
+        candidates = lastRows;
+    } else {
+        candidates = termRows(terms.first());
+        for (int i = 1; i < terms.size() && !candidates.isEmpty(); ++i) {
+            candidates = intersect(candidates, termRows(terms[i]));
+        }
+    }
+
+    QVector<Match> matches;
+    QVector<int> rows;
+    for (int row : candidates) {
+        const int rowScore = score(row, terms);
+        if (rowScore > 0) {
+            matches.append({row, rowScore});
+            rows.append(row);
+        }
+    }
+
+    lastQuery = normalized;
+    lastRows = rows;
+
+    std::stable_sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) { return a.score > b.score; });
+    return matches;
+}
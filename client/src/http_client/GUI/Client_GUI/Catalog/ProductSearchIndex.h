@@ -0,0 +1,57 @@
+#ifndef HTTP_CLIENT_PRODUCTSEARCHINDEX_H
+#define HTTP_CLIENT_PRODUCTSEARCHINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include "ProductTableModel.h"
+
+// Локальный полнотекстовый индекс каталога.
+// Слова названий, описаний, номера и цены лежат в словаре с поиском по префиксу,
+// для подстрок внутри названий есть триграммный индекс. Текст приводится к единому регистру
+// через toCaseFolded(), поэтому кириллица ищется без учёта регистра.
+class ProductSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Match
+    {
+        int row;
+        int score;
+    };
+
+    explicit ProductSearchIndex(ProductTableModel *model, QObject *parent = nullptr);
+
+    // Совпадения отсортированы по убыванию релевантности
+    QVector<Match> search(const QString &query);
+
+private slots:
+    void rebuild();
+    void addRows(const QModelIndex &parent, int first, int last);
+
+private:
+    const QString &folded(int stringRef);
+    void addToken(const QString &token, int row);
+    void addText(const QString &text, int row, bool withTrigrams);
+    QVector<int> tokenPrefixRows(const QString &prefix);
+    QVector<int> trigramRows(const QString &term) const;
+    QVector<int> termRows(const QString &term);
+    int score(int row, const QStringList &terms);
+
+    ProductTableModel *model;
+
+    QHash<QString, QVector<int>> tokens;
+    QStringList sortedTokens; // пустой - требует пересортировки после добавления строк
+    QHash<quint64, QVector<int>> trigrams;
+    QVector<QString> foldedStrings; // по индексу строки в пуле ProductStore
+    int foldedVersion = 0; // версия пула, для которой заполнен foldedStrings
+
+    // Набор результатов предыдущего запроса: если пользователь дописывает запрос,
+    // поиск идёт только среди них
+    QString lastQuery;
+    QVector<int> lastRows;
+};
+
+#endif //HTTP_CLIENT_PRODUCTSEARCHINDEX_H
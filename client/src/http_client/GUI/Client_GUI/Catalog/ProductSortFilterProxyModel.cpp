@@ -0,0 +1,148 @@
+#include "ProductSortFilterProxyModel.h"
+#include <QCollator>
+#include <algorithm>
+#include <numeric>
+
+ProductSortFilterProxyModel::ProductSortFilterProxyModel(ProductTableModel *source, QObject *parent)
+        : QSortFilterProxyModel(parent), source(source)
+{
+    setSourceModel(source);
+    setDynamicSortFilter(true);
+
+    // Ранги пересчитываются лениво при следующем сравнении
+    connect(source, &QAbstractItemModel::modelAboutToBeReset, this, &ProductSortFilterProxyModel::invalidateRanks);
+    connect(source, &QAbstractItemModel::rowsAboutToBeInserted, this, &ProductSortFilterProxyModel::invalidateRanks);
+    // После правок на месте ранги и порядок строк пересчитываются один раз на всю пачку изменений
+    connect(source, &ProductTableModel::catalogPatched, this, [this]() {
+        invalidateRanks();
+        invalidate();
+    });
+}
+
+int ProductSortFilterProxyModel::productId(int proxyRow) const
+{
+    return source->productId(mapToSource(index(proxyRow, 0)).row());
+}
+
+void ProductSortFilterProxyModel::setSearchScores(const QVector<int> &scores)
+{
+    searchScores = scores;
+    searching = true;
+    invalidateFilter();
+    if (byRelevance) {
+        invalidate();
+    }
+}
+
+void ProductSortFilterProxyModel::clearSearch()
+{
+    if (!searching) {
+        return;
+    }
+
+    searchScores.clear();
+    searching = false;
+    if (byRelevance) {
+        byRelevance = false;
+        QSortFilterProxyModel::sort(-1);
+    }
+    invalidateFilter();
+}
+
+void ProductSortFilterProxyModel::sortByRelevance()
+{
+    byRelevance = true;
+    // Колонка 0 лишь включает сортировку прокси; порядок определяет lessThan
+    QSortFilterProxyModel::sort(0, Qt::AscendingOrder);
+    invalidate();
+}
+
+void ProductSortFilterProxyModel::sort(int column, Qt::SortOrder order)
+{
+    byRelevance = false;
+    QSortFilterProxyModel::sort(column, order);
+}
+
+bool ProductSortFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &) const
+{
+    if (!searching) {
+        return true;
+    }
+    // Строки, дозагруженные после поиска, показываются только после его повторного запуска
+    return sourceRow < searchScores.size() && searchScores[sourceRow] >= 0;
+}
+
+void ProductSortFilterProxyModel::invalidateRanks()
+{
+    nameRanks.clear();
+    descriptionRanks.clear();
+}
+
+const QVector<int> &ProductSortFilterProxyModel::textRanks(int column) const
+{
+    const ProductStore &store = source->products();
+    const bool byName = column == ProductTableModel::NameColumn;
+    QVector<int> &ranks = byName ? nameRanks : descriptionRanks;
+
+    if (ranks.size() == store.size()) {
+        return ranks;
+    }
+
+    // Строки сортируются один раз с учётом локали; дальше сравниваются целые ранги
+    QCollator collator;
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    collator.setNumericMode(true);
+
+    auto text = [&](int row) -> const QString & { return byName ? store.name(row) : store.description(row); };
+
+    QVector<int> order(store.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return collator.compare(text(a), text(b)) < 0; });
+
+    ranks.resize(store.size());
+    int rank = 0;
+    for (int i = 0; i < order.size(); ++i) {
+        if (i > 0 && collator.compare(text(order[i - 1]), text(order[i])) != 0) {
+            ++rank;
+        }
+        ranks[order[i]] = rank;
+    }
+    return ranks;
+}
+
+bool ProductSortFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    const ProductStore &store = source->products();
+    const int l = left.row();
+    const int r = right.row();
+
+    if (byRelevance && l < searchScores.size() && r < searchScores.size() && searchScores[l] != searchScores[r]) {
+        return searchScores[l] > searchScores[r];
+    }
+
+    switch (left.column()) {
+        case ProductTableModel::NameColumn:
+        case ProductTableModel::DescriptionColumn: {
+            const QVector<int> &ranks = textRanks(left.column());
+            if (ranks[l] != ranks[r]) {
+                return ranks[l] < ranks[r];
+            }
+            break;
+        }
+        case ProductTableModel::WholesalePriceColumn:
+            if (store.wholesalePrice(l) != store.wholesalePrice(r)) {
+                return store.wholesalePrice(l) < store.wholesalePrice(r);
+            }
+            break;
+        case ProductTableModel::RetailPriceColumn:
+            if (store.retailPrice(l) != store.retailPrice(r)) {
+                return store.retailPrice(l) < store.retailPrice(r);
+            }
+            break;
+        default:
+            break;
+    }
+
+    // При равенстве порядок определяется номером товара, как и на сервере
+    return store.id(l) < store.id(r);
+}
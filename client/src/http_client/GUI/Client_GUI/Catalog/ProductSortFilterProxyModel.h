@@ -0,0 +1,44 @@
+#ifndef HTTP_CLIENT_PRODUCTSORTFILTERPROXYMODEL_H
+#define HTTP_CLIENT_PRODUCTSORTFILTERPROXYMODEL_H
+
+#include <QSortFilterProxyModel>
+#include <QVector>
+#include "ProductTableModel.h"
+
+// Локальная сортировка загруженного каталога. Сравнение идёт напрямую по колонкам ProductStore,
+// а для текстовых колонок - по заранее посчитанным рангам строк, без QVariant и без сети.
+class ProductSortFilterProxyModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit ProductSortFilterProxyModel(ProductTableModel *source, QObject *parent = nullptr);
+
+    int productId(int proxyRow) const;
+
+    // Результат локального поиска: scores[row] - релевантность строки, -1 - строка отфильтрована
+    void setSearchScores(const QVector<int> &scores);
+    void clearSearch();
+    // Порядок по релевантности поиска; сбрасывается при сортировке по колонке
+    void sortByRelevance();
+
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
+private:
+    const QVector<int> &textRanks(int column) const;
+    void invalidateRanks();
+
+    ProductTableModel *source;
+    mutable QVector<int> nameRanks;
+    mutable QVector<int> descriptionRanks;
+
+    QVector<int> searchScores;
+    bool searching = false;
+    bool byRelevance = false;
+};
+
+#endif //HTTP_CLIENT_PRODUCTSORTFILTERPROXYMODEL_H
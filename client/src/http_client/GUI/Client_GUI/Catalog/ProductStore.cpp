@@ -0,0 +1,217 @@
+#include "ProductStore.h"
+#include <QJsonObject>
+#include <algorithm>
+
+void ProductStore::clear()
+{
+    // QVector::clear() сохраняет ёмкость, поэтому повторная загрузка не перевыделяет память
+    ids.clear();
+    wholesalePrices.clear();
+    retailPrices.clear();
+    nameRefs.clear();
+    descriptionRefs.clear();
+    imageHashes.clear();
+    imageKeys.clear();
+    rowById.clear();
+    stringUses.fill(0);
+    liveStrings = 0;
+}
+
+void ProductStore::reserve(int count)
+{
+    ids.reserve(count);
+    wholesalePrices.reserve(count);
+    retailPrices.reserve(count);
+    nameRefs.reserve(count);
+    descriptionRefs.reserve(count);
+    imageHashes.reserve(count);
+    imageKeys.reserve(count);
+    rowById.reserve(count);
+}
+
+void ProductStore::load(const QJsonArray &products)
+{
+    clear();
+    append(products);
+}
+
+void ProductStore::load(const QVector<Dto::Product> &products)
+{
+    clear();
+    append(products);
+}
+
+void ProductStore::append(const QJsonArray &products)
+{
+    reserve(size() + products.size());
+
+    for (const QJsonValue &value : products) {
+        QJsonObject item = value.toObject();
+        append(item["ProductID"].toInt(),
+               item["WholesalePrice"].toDouble(),
+               item["RetailPrice"].toDouble(),
+               item["Name"].toString(),
+               item["Description"].toString(),
+               item["ImageHash"].toString());
+    }
+}
+
+void ProductStore::append(const QVector<Dto::Product> &products)
+{
+    reserve(size() + products.size());
+
+    for (const Dto::Product &product : products) {
+        append(product.id, product.wholesalePrice, product.retailPrice,
+               product.name, product.description, product.imageHash);
+    }
+}
+
+int ProductStore::append(int id, double wholesalePrice, double retailPrice,
+                         const QString &name, const QString &description, const QString &imageHash)
+{
+    const int row = ids.size();
+    ids.append(id);
+    wholesalePrices.append(wholesalePrice);
+    retailPrices.append(retailPrice);
+    nameRefs.append(intern(name));
+    descriptionRefs.append(intern(description));
+    imageHashes.append(imageHash);
+    imageKeys.append(qHash(imageHash));
+    rowById.insert(id, row);
+    return row;
+}
+
+void ProductStore::update(int row, const Dto::Product &product)
+{
+    wholesalePrices[row] = product.wholesalePrice;
+    retailPrices[row] = product.retailPrice;
+    // Новые строки занимаются до освобождения старых: неизменившееся название остаётся в пуле
+    const int oldName = nameRefs[row];
+    const int oldDescription = descriptionRefs[row];
+    nameRefs[row] = intern(product.name);
+    descriptionRefs[row] = intern(product.description);
+    release(oldName);
+    release(oldDescription);
+    imageHashes[row] = product.imageHash;
+    imageKeys[row] = qHash(product.imageHash);
+    compactStrings();
+}
+
+QVector<int> ProductStore::removeIds(const QVector<int> &productIds)
+{
+    QVector<int> removed;
+    removed.reserve(productIds.size());
+    for (int productId : productIds) {
+        const int row = rowOf(productId);
+        if (row >= 0) {
+            removed.append(row);
+        }
+    }
+    if (removed.isEmpty()) {
+        return removed;
+    }
+    std::sort(removed.begin(), removed.end());
+    removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+
+    // Каждая колонка сдвигается один раз, номера строк в rowById пересчитываются только для сдвинутых
+    int next = 0;
+    int write = removed.first();
+    for (int row = removed.first(); row < ids.size(); ++row) {
+        if (next < removed.size() && removed[next] == row) {
+            ++next;
+            rowById.remove(ids[row]);
+            release(nameRefs[row]);
+            release(descriptionRefs[row]);
+            continue;
+        }
+
+        ids[write] = ids[row];
+        wholesalePrices[write] = wholesalePrices[row];
+        retailPrices[write] = retailPrices[row];
+        nameRefs[write] = nameRefs[row];
+        descriptionRefs[write] = descriptionRefs[row];
+        imageHashes[write] = std::move(imageHashes[row]);
+        imageKeys[write] = imageKeys[row];
+        rowById[ids[write]] = write;
+        ++write;
+    }
+
+    ids.resize(write);
+    wholesalePrices.resize(write);
+    retailPrices.resize(write);
+    nameRefs.resize(write);
+    descriptionRefs.resize(write);
+    imageHashes.resize(write);
+    imageKeys.resize(write);
+
+    compactStrings();
+    return removed;
+}
+
+int ProductStore::intern(const QString &value)
+{
+    auto it = stringIndex.constFind(value);
+    if (it != stringIndex.constEnd()) {
+        if (stringUses[it.value()]++ == 0) {
+            ++liveStrings;
+        }
+        return it.value();
+    }
+
+    const int ref = strings.size();
+    strings.append(value);
+    stringUses.append(1);
+    stringIndex.insert(value, ref);
+    ++liveStrings;
+    return ref;
+}
+
+void ProductStore::release(int ref)
+{
+    if (--stringUses[ref] == 0) {
+        --liveStrings;
+    }
+}
+
+void ProductStore::compactStrings()
+{
+    // Пул перестраивается, когда мёртвых строк стало больше, чем живых: цена перестройки
+    // делится на все удаления и правки, которые её накопили
+    const int dead = strings.size() - liveStrings;
+    if (dead < MinDeadStrings || dead <= liveStrings) {
+        return;
+    }
+
+    QVector<int> remap(strings.size(), -1);
+    QVector<QString> liveValues;
+    QVector<int> liveUses;
+    liveValues.reserve(liveStrings);
+    liveUses.reserve(liveStrings);
+    stringIndex.clear();
+    stringIndex.reserve(liveStrings);
+    for (int ref = 0; ref < strings.size(); ++ref) {
+        if (stringUses[ref] == 0) {
+            continue;
+        }
+        remap[ref] = liveValues.size();
+        stringIndex.insert(strings[ref], liveValues.size());
+        liveValues.append(std::move(strings[ref]));
+        liveUses.append(stringUses[ref]);
+    }
+
+    for (int &ref : nameRefs) {
+        ref = remap[ref];
+    }
+    for (int &ref : descriptionRefs) {
+        ref = remap[ref];
+    }
+    strings.swap(liveValues);
+    stringUses.swap(liveUses);
+    ++poolVersion;
+}
+
+QString ProductStore::imageUrl(int row) const
+{
+    // Версия в URL делает адрес неизменяемым: HTTP-кэш отдаёт картинку, пока хэш не поменялся
+    return QString("/products/%1/image?v=%2").arg(ids[row]).arg(imageHashes[row]);
+}
@@ -0,0 +1,74 @@
+#ifndef HTTP_CLIENT_PRODUCTSTORE_H
+#define HTTP_CLIENT_PRODUCTSTORE_H
+
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QJsonArray>
+#include "http_client/http_requests/Dto.h"
+
+// Колоночное хранилище каталога: числовые поля лежат в плотных массивах,
+// повторяющиеся строки хранятся один раз в пуле и адресуются по индексу.
+class ProductStore
+{
+public:
+    void clear();
+    void reserve(int count);
+    void load(const QJsonArray &products);
+    void load(const QVector<Dto::Product> &products);
+    void append(const QJsonArray &products);
+    void append(const QVector<Dto::Product> &products);
+    int append(int id, double wholesalePrice, double retailPrice,
+               const QString &name, const QString &description, const QString &imageHash);
+    // Точечные правки из дельты каталога; номер товара у строки не меняется
+    void update(int row, const Dto::Product &product);
+    // Удаление за один проход: оставшиеся строки сдвигаются вверх с сохранением порядка.
+    // Возвращает номера удалённых строк (до удаления) по возрастанию
+    QVector<int> removeIds(const QVector<int> &productIds);
+
+    int size() const { return ids.size(); }
+    int rowOf(int productId) const { return rowById.value(productId, -1); }
+
+    int id(int row) const { return ids[row]; }
+    double wholesalePrice(int row) const { return wholesalePrices[row]; }
+    double retailPrice(int row) const { return retailPrices[row]; }
+    const QString &name(int row) const { return strings[nameRefs[row]]; }
+    const QString &description(int row) const { return strings[descriptionRefs[row]]; }
+    // Индексы строк в пуле: одинаковые названия и описания имеют одинаковый индекс
+    int nameRef(int row) const { return nameRefs[row]; }
+    int descriptionRef(int row) const { return descriptionRefs[row]; }
+    const QString &string(int ref) const { return strings[ref]; }
+    // Меняется, когда пул сжимается и индексы строк перенумеровываются
+    int stringsVersion() const { return poolVersion; }
+    bool hasImage(int row) const { return !imageHashes[row].isEmpty(); }
+    const QString &imageHash(int row) const { return imageHashes[row]; }
+    uint imageKey(int row) const { return imageKeys[row]; }
+    QString imageUrl(int row) const;
+
+private:
+    int intern(const QString &value);
+    void release(int ref);
+    void compactStrings();
+
+    QVector<int> ids;
+    QVector<double> wholesalePrices;
+    QVector<double> retailPrices;
+    QVector<int> nameRefs;
+    QVector<int> descriptionRefs;
+    QVector<QString> imageHashes; // хэш содержимого картинки от сервера, пустой - картинки нет
+    QVector<uint> imageKeys;
+    QHash<int, int> rowById;
+
+    // Пул строк переживает перезагрузку каталога: после сортировки или поиска
+    // приходят те же названия и описания, и они не копируются заново.
+    // Строки, на которые больше не ссылается ни одна строка каталога, убираются при правках из дельт
+    QVector<QString> strings;
+    QVector<int> stringUses;
+    QHash<QString, int> stringIndex;
+    int liveStrings = 0;
+    int poolVersion = 0;
+
+    static const int MinDeadStrings = 1024;
+};
+
+#endif //HTTP_CLIENT_PRODUCTSTORE_H
@@ -0,0 +1,516 @@
+#include "ProductTableModel.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QFont>
+#include <QFutureWatcher>
+#include <QPixmap>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include "http_client/http_requests/Requests.h"
+#include "http_client/metrics/Metrics.h"
+
+ProductTableModel::ProductTableModel(Requests *requests, QObject *parent)
+        : QAbstractTableModel(parent), requests(requests), thumbnails(new ThumbnailCache(requests, this)),
+          snapshotTimer(new QTimer(this))
+{
+    connect(thumbnails, &ThumbnailCache::thumbnailReady, this, &ProductTableModel::onThumbnailReady);
+
+    snapshotPool.setMaxThreadCount(1);
+    snapshotTimer->setSingleShot(true);
+    snapshotTimer->setInterval(SnapshotSaveDelayMs);
+    connect(snapshotTimer, &QTimer::timeout, this, &ProductTableModel::saveSnapshot);
+}
+
+ProductTableModel::~ProductTableModel()
+{
+    // Цикла событий уже нет: дожидаемся начатой записи, затем дописываем то, что изменилось после неё
+    snapshotTimer->stop();
+    snapshotPool.waitForDone();
+    snapshotWriting = false;
+    saveSnapshot();
+    snapshotPool.waitForDone();
+    thumbnails->setSnapshot(nullptr);
+}
+
+void ProductTableModel::reload(const QString &sort)
+{
+    beginResetModel();
+    store.clear();
+    sortBy = sort;
+    nextCursor.clear();
+    hasMorePages = true;
+    // Загрузка считается начатой уже с запроса версии: иначе представление (canFetchMore)
+    // или fetchAll() запросили бы первую страницу второй раз
+    fetching = true;
+    fetchingAll = false;
+    syncing = false;
+    ++generation;
+    catalogVersion.clear();
+    endResetModel();
+
+    // Версия запрашивается до страниц: если каталог поменяется во время загрузки,
+    // снимок получит более старую версию и при следующем запуске обновится
+    const int requestGeneration = generation;
+    requests->getCatalogVersionAsync(QString(), this, [this, requestGeneration](bool ok, bool, const QString &version) {
+        if (requestGeneration != generation) {
+            return;
+        }
+        if (ok && sortBy.isEmpty()) {
+            catalogVersion = version;
+        }
+        requestPage();
+    });
+}
+
+void ProductTableModel::fetchAll()
+{
+    if (!hasMorePages) {
+        return;
+    }
+
+    fetchingAll = true;
+    if (!fetching) {
+        requestPage();
+    }
+}
+
+void ProductTableModel::loadProducts(const QJsonArray &products)
+{
+    beginResetModel();
+    store.load(products);
+    hasMorePages = false;
+    fetching = false;
+    fetchingAll = false;
+    syncing = false;
+    ++generation;
+    endResetModel();
+}
+
+bool ProductTableModel::restoreSnapshot()
+{
+    if (!snapshot.open(CatalogSnapshot::defaultPath())) {
+        return false;
+    }
+
+    Metrics::ScopedTimer timer("ui: catalog rebuild");
+    beginResetModel();
+    store.load(snapshot.takeProducts());
+    sortBy.clear();
+    nextCursor.clear();
+    hasMorePages = false;
+    fetching = false;
+    fetchingAll = false;
+    syncing = false;
+    ++generation;
+    catalogVersion = snapshot.version();
+    snapshotDirty = false;
+    endResetModel();
+
+    thumbnails->setSnapshot(&snapshot);
+    return true;
+}
+
+bool ProductTableModel::revalidate()
+{
+    if (catalogVersion.isEmpty() || hasMorePages || !sortBy.isEmpty()) {
+        return false;
+    }
+
+    if (!syncing) {
+        requestChanges();
+    }
+    return true;
+}
+
+void ProductTableModel::requestChanges()
+{
+    syncing = true;
+    const int requestGeneration = generation;
+
+    requests->getCatalogChangesAsync(catalogVersion, this,
+                                     [this, requestGeneration](bool ok, const Dto::CatalogChanges &changes) {
+        if (requestGeneration != generation) {
+            return;
+        }
+
+        // Сервер недоступен - продолжаем работать с тем, что есть
+        if (!ok) {
+            syncing = false;
+            return;
+        }
+
+        if (changes.reset) {
+            pendingProducts.clear();
+            pendingVersion = changes.version;
+            requestBackgroundPage(QString());
+            return;
+        }
+
+        const bool patched = !changes.products.isEmpty() || !changes.deleted.isEmpty();
+        if (patched) {
+            applyChanges(changes);
+            // Пустая дельта снимок не трогает; миниатюры, подгруженные с прошлого сохранения, запишутся при выходе
+            scheduleSnapshot();
+            emit catalogPatched();
+        }
+        catalogVersion = changes.version;
+
+        if (changes.hasMore) {
+            requestChanges();
+            return;
+        }
+
+        syncing = false;
+    });
+}
+
+void ProductTableModel::applyChanges(const Dto::CatalogChanges &changes)
+{
+    // Удаления идут последними: пока не пришёл catalogPatched, номера строк,
+    // которые видели подписчики rowsInserted, остаются действительными
+    Metrics::ScopedTimer timer("ui: catalog patch");
+    QVector<Dto::Product> added;
+    for (const Dto::Product &product : changes.products) {
+        const int row = store.rowOf(product.id);
+        if (row < 0) {
+            added.append(product);
+            continue;
+        }
+
+        store.update(row, product);
+        emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+    }
+
+    if (!added.isEmpty()) {
+        beginInsertRows(QModelIndex(), store.size(), store.size() + added.size() - 1);
+        store.append(added);
+        endInsertRows();
+    }
+
+    removeProducts(changes.deleted);
+}
+
+void ProductTableModel::removeProducts(const QVector<int> &productIds)
+{
+    QVector<int> rows;
+    for (int productId : productIds) {
+        const int row = store.rowOf(productId);
+        if (row >= 0) {
+            rows.append(row);
+        }
+    }
+    if (rows.isEmpty()) {
+        return;
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    // Диапазоны подряд идущих строк; обычно удаление одно и диапазон один
+    QVector<QPair<int, int>> ranges;
+    for (int row : rows) {
+        if (!ranges.isEmpty() && ranges.last().second + 1 == row) {
+            ranges.last().second = row;
+        } else {
+            ranges.append({row, row});
+        }
+    }
+
+    // Много разрозненных строк: один проход по хранилищу дешевле сдвига хвоста на каждый диапазон
+    if (ranges.size() > MaxRemoveRanges) {
+        beginResetModel();
+        store.removeIds(productIds);
+        endResetModel();
+        return;
+    }
+
+    // С конца: удаление диапазона не сдвигает номера строк в диапазонах выше него
+    for (int i = ranges.size() - 1; i >= 0; --i) {
+        const QPair<int, int> &range = ranges.at(i);
+        QVector<int> ids;
+        ids.reserve(range.second - range.first + 1);
+        for (int row = range.first; row <= range.second; ++row) {
+            ids.append(store.id(row));
+        }
+
+        beginRemoveRows(QModelIndex(), range.first, range.second);
+        store.removeIds(ids);
+        endRemoveRows();
+    }
+}
+
+void ProductTableModel::requestBackgroundPage(const QString &cursor)
+{
+    const int requestGeneration = generation;
+    requests->getProductsPageAsync(QString(), cursor, BackgroundPageSize, this,
+                                   [this, requestGeneration](bool ok, const Dto::ProductsPage &page) {
+        // Пользователь успел перезагрузить каталог сам: его загрузка важнее
+        if (requestGeneration != generation) {
+            pendingProducts.clear();
+            return;
+        }
+        // Сеть пропала: каталог остаётся как есть
+        if (!ok) {
+            pendingProducts.clear();
+            syncing = false;
+            return;
+        }
+
+        pendingProducts += page.products;
+        if (!page.nextCursor.isEmpty()) {
+            requestBackgroundPage(page.nextCursor);
+            return;
+        }
+
+        Metrics::ScopedTimer timer("ui: catalog rebuild");
+        beginResetModel();
+        store.load(pendingProducts);
+        syncing = false;
+        ++generation;
+        catalogVersion = pendingVersion;
+        endResetModel();
+        pendingProducts.clear();
+
+        scheduleSnapshot();
+        emit catalogLoaded();
+    });
+}
+
+void ProductTableModel::scheduleSnapshot()
+{
+    snapshotDirty = true;
+    // Таймер не перезапускается: поток дельт не откладывает запись бесконечно
+    if (!snapshotTimer->isActive()) {
+        snapshotTimer->start();
+    }
+}
+
+void ProductTableModel::saveSnapshot()
+{
+    if (!snapshotDirty || catalogVersion.isEmpty() || hasMorePages || !sortBy.isEmpty()) {
+        return;
+    }
+    // Изменения, пришедшие во время записи, запишутся следующей
+    if (snapshotWriting) {
+        snapshotTimer->start();
+        return;
+    }
+
+    const QString path = CatalogSnapshot::defaultPath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // В GUI-потоке только собираются данные: копия хранилища разделяет массивы с оригиналом,
+    // а миниатюры из кэша - готовые QImage. Сжатие и запись идут в рабочем потоке
+    const ProductStore products = store;
+    const bool reuseSaved = snapshot.isOpen() && snapshot.thumbnailSize() == thumbnails->size();
+    QHash<ThumbnailKey, QImage> decoded;
+    for (int row = 0; row < store.size(); ++row) {
+        if (!store.hasImage(row)) {
+            continue;
+        }
+        const ThumbnailKey key{store.id(row), store.imageKey(row)};
+        if (reuseSaved && snapshot.hasThumbnail(key)) {
+            continue; // перенесётся из прежнего файла
+        }
+        const QImage image = thumbnails->image(key);
+        if (!image.isNull()) {
+            decoded.insert(key, image);
+        }
+    }
+
+    // Старый файл отображён в память: закрываем его до замены (на Windows иначе замена не пройдёт).
+    // Пока идёт запись, миниатюры берутся из HTTP-кэша
+    thumbnails->setSnapshot(nullptr);
+    snapshot.close();
+    snapshotDirty = false;
+    snapshotWriting = true;
+
+    const QString version = catalogVersion;
+    const int size = thumbnails->size();
+    auto *watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, path]() {
+        watcher->deleteLater();
+        snapshotWriting = false;
+        if (!watcher->result()) {
+            snapshotDirty = true;
+        }
+        if (snapshot.open(path, false)) {
+            thumbnails->setSnapshot(&snapshot);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(&snapshotPool, [path, version, products, size, decoded]() {
+        Metrics::ScopedTimer timer("ui: snapshot write");
+        return CatalogSnapshot::save(path, version, products, size, decoded);
+    }));
+}
+
+bool ProductTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && hasMorePages && !fetching;
+}
+
+void ProductTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (canFetchMore(parent)) {
+        requestPage();
+    }
+}
+
+void ProductTableModel::requestPage()
+{
+    fetching = true;
+    const int requestGeneration = generation;
+
+    requests->getProductsPageAsync(sortBy, nextCursor, PageSize, this,
+                                   [this, requestGeneration](bool ok, const Dto::ProductsPage &page) {
+        if (requestGeneration != generation) {
+            return;
+        }
+
+        fetching = false;
+        if (!ok) {
+            // Следующую попытку сделает представление при очередной прокрутке
+            fetchingAll = false;
+            if (store.size() == 0) {
+                hasMorePages = false;
+                emit loadFailed();
+            }
+            return;
+        }
+
+        nextCursor = page.nextCursor;
+        hasMorePages = !nextCursor.isEmpty();
+
+        if (!page.products.isEmpty()) {
+            // Вместе с обновлением представления, которое подписано на вставку строк
+            Metrics::ScopedTimer timer("ui: catalog page insert");
+            beginInsertRows(QModelIndex(), store.size(), store.size() + page.products.size() - 1);
+            store.append(page.products);
+            endInsertRows();
+        }
+
+        if (!hasMorePages) {
+            fetchingAll = false;
+            scheduleSnapshot();
+            emit catalogLoaded();
+        } else if (fetchingAll) {
+            requestPage();
+        }
+    });
+}
+
+int ProductTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : store.size();
+}
+
+int ProductTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant ProductTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= store.size()) {
+        return QVariant();
+    }
+
+    const int row = index.row();
+
+    if (role == Qt::DecorationRole && index.column() == PhotoColumn) {
+        return thumbnail(row);
+    }
+
+    if (role == Qt::FontRole && index.column() == InCartColumn && unconfirmedCart.contains(store.id(row))) {
+        QFont font;
+        font.setItalic(true);
+        return font;
+    }
+
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+        case IdColumn:
+            return QString::number(store.id(row));
+        case NameColumn:
+            return store.name(row);
+        case WholesalePriceColumn:
+            return QString::number(store.wholesalePrice(row), 'f', 2) + " ₽";
+        case RetailPriceColumn:
+            return QString::number(store.retailPrice(row), 'f', 2) + " ₽";
+        case InCartColumn: {
+            const int quantity = cartQuantities.value(store.id(row));
+            return quantity > 0 ? QString::number(quantity) : QString();
+        }
+        case DescriptionColumn:
+            return store.description(row);
+        default:
+            return QVariant();
+    }
+}
+
+QVariant ProductTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    static const QStringList headers = {"ID", "Фото", "Название", "Оптовая цена", "Розничная цена", "В корзине", "Описание"};
+    return headers.value(section);
+}
+
+void ProductTableModel::setCartQuantities(const QHash<int, int> &quantities, const QSet<int> &unconfirmed)
+{
+    QSet<int> changed = unconfirmed + unconfirmedCart;
+    for (auto it = quantities.constBegin(); it != quantities.constEnd(); ++it) {
+        if (cartQuantities.value(it.key()) != it.value()) {
+            changed.insert(it.key());
+        }
+    }
+    for (auto it = cartQuantities.constBegin(); it != cartQuantities.constEnd(); ++it) {
+        if (!quantities.contains(it.key())) {
+            changed.insert(it.key());
+        }
+    }
+
+    cartQuantities = quantities;
+    unconfirmedCart = unconfirmed;
+
+    for (int productId : changed) {
+        const int row = store.rowOf(productId);
+        if (row >= 0) {
+            const QModelIndex cell = index(row, InCartColumn);
+            emit dataChanged(cell, cell, {Qt::DisplayRole, Qt::FontRole});
+        }
+    }
+}
+
+QVariant ProductTableModel::thumbnail(int row) const
+{
+    if (!store.hasImage(row)) {
+        return QVariant();
+    }
+
+    // data() вызывается только для видимых строк, поэтому и декодирование запускается только для них
+    QPixmap pixmap = thumbnails->thumbnail(store.id(row), store.imageKey(row), store.imageUrl(row));
+    if (pixmap.isNull()) {
+        return QVariant();
+    }
+    return pixmap;
+}
+
+void ProductTableModel::onThumbnailReady(int productId, uint imageHash, bool fromSnapshot)
+{
+    const int row = store.rowOf(productId);
+    if (row < 0 || store.imageKey(row) != imageHash) {
+        return;
+    }
+
+    // Новая миниатюра попадёт в снимок при следующей записи или при выходе
+    if (!fromSnapshot) {
+        snapshotDirty = true;
+    }
+    const QModelIndex cell = index(row, PhotoColumn);
+    emit dataChanged(cell, cell, {Qt::DecorationRole});
+}
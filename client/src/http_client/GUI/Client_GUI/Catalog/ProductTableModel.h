@@ -0,0 +1,119 @@
+#ifndef HTTP_CLIENT_PRODUCTTABLEMODEL_H
+#define HTTP_CLIENT_PRODUCTTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QJsonArray>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+#include "ProductStore.h"
+#include "ThumbnailCache.h"
+#include "CatalogSnapshot.h"
+
+class Requests;
+
+// Модель каталога поверх ProductStore: ячейки не хранятся, а формируются
+// в data() только для строк, которые представление действительно рисует.
+class ProductTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        IdColumn,
+        PhotoColumn,
+        NameColumn,
+        WholesalePriceColumn,
+        RetailPriceColumn,
+        InCartColumn,
+        DescriptionColumn,
+        ColumnCount
+    };
+
+    explicit ProductTableModel(Requests *requests, QObject *parent = nullptr);
+    ~ProductTableModel() override;
+
+    // Постраничная загрузка каталога: первая страница запрашивается сразу, следующие - по мере прокрутки
+    void reload(const QString &sortBy = QString());
+    // Догрузить все оставшиеся страницы (нужно для локальной сортировки всего каталога)
+    void fetchAll();
+    bool isComplete() const { return !hasMorePages; }
+    // Готовый набор строк без догрузки (например, результаты поиска)
+    void loadProducts(const QJsonArray &products);
+
+    // Показать каталог из снимка на диске; false - снимка нет или он повреждён
+    bool restoreSnapshot();
+    // Догнать сервер по изменениям после известной версии каталога. Работает только для
+    // полного каталога в порядке по умолчанию; false - применять дельту не к чему
+    bool revalidate();
+    // Записать полный каталог вместе с миниатюрами в фоне; частично загруженный каталог не сохраняется
+    void saveSnapshot();
+
+    int productId(int row) const { return store.id(row); }
+    const ProductStore &products() const { return store; }
+
+    void setImageSize(int size) { thumbnails->setThumbnailSize(size); }
+
+    // Количество товаров в корзине для колонки "В корзине"; unconfirmed - товары с изменениями,
+    // которые ещё не подтвердил сервер (показываются курсивом). Перерисовываются только изменившиеся строки
+    void setCartQuantities(const QHash<int, int> &quantities, const QSet<int> &unconfirmed);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    static const int PageSize = 100;
+    static const int BackgroundPageSize = 500;
+    static const int SnapshotSaveDelayMs = 10 * 1000;
+    static const int MaxRemoveRanges = 16;
+
+signals:
+    void loadFailed();
+    void catalogLoaded();
+    // Часть строк изменена или удалена на месте: номера строк могли сдвинуться
+    void catalogPatched();
+
+private slots:
+    void onThumbnailReady(int productId, uint imageHash, bool fromSnapshot);
+
+private:
+    QVariant thumbnail(int row) const;
+    void requestPage();
+    void requestBackgroundPage(const QString &cursor);
+    void requestChanges();
+    void applyChanges(const Dto::CatalogChanges &changes);
+    void removeProducts(const QVector<int> &productIds);
+    // Каталог изменился: снимок перепишется после паузы, серия дельт даёт одну запись
+    void scheduleSnapshot();
+
+    Requests *requests;
+    ProductStore store;
+    ThumbnailCache *thumbnails;
+
+    QString sortBy;
+    QString nextCursor;
+    bool hasMorePages = false;
+    bool fetching = false;
+    bool fetchingAll = false;
+    int generation = 0; // страницы от предыдущей загрузки отбрасываются
+
+    CatalogSnapshot snapshot;
+    QString catalogVersion; // версия сервера, которой соответствует store; пустая - неизвестна
+    bool snapshotDirty = false;
+    bool snapshotWriting = false;
+    QTimer *snapshotTimer;
+    QThreadPool snapshotPool; // один поток: снимок пишется вне GUI-потока и не двумя заданиями сразу
+    bool syncing = false; // идёт запрос изменений или фоновая перезагрузка
+    // Каталог, который догружается в фоне и заменит store целиком (если дельта недоступна)
+    QVector<Dto::Product> pendingProducts;
+    QString pendingVersion;
+
+    QHash<int, int> cartQuantities; // номер товара -> количество в корзине
+    QSet<int> unconfirmedCart;
+};
+
+#endif //HTTP_CLIENT_PRODUCTTABLEMODEL_H
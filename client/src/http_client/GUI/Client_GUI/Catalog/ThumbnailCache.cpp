@@ -0,0 +1,111 @@
+#include "ThumbnailCache.h"
+#include <QFutureWatcher>
+#include <QImage>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+#include "http_client/http_requests/Requests.h"
+#include "CatalogSnapshot.h"
+#include "http_client/metrics/Metrics.h"
+
+ThumbnailCache::ThumbnailCache(Requests *requests, QObject *parent) : QObject(parent), requests(requests)
+{
+    cache.setMaxCost(64 * 1024 * 1024);
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+void ThumbnailCache::setThumbnailSize(int size)
+{
+    if (size == thumbnailSize) {
+        return;
+    }
+
+    thumbnailSize = size;
+    cache.clear();
+}
+
+QPixmap ThumbnailCache::thumbnail(int productId, uint imageHash, const QString &imageUrl)
+{
+    const ThumbnailKey key{productId, imageHash};
+
+    if (QPixmap *cached = cache.object(key)) {
+        return *cached;
+    }
+
+    if (pending.contains(key)) {
+        return QPixmap();
+    }
+
+    if (snapshot && snapshot->thumbnailSize() == thumbnailSize) {
+        const QByteArray saved = snapshot->thumbnail(key);
+        if (!saved.isEmpty()) {
+            pending.insert(key);
+            decode(key, saved, true);
+            return QPixmap();
+        }
+    }
+
+    load(key, imageUrl);
+    return QPixmap();
+}
+
+QImage ThumbnailCache::image(const ThumbnailKey &key) const
+{
+    if (const QPixmap *cached = cache.object(key)) {
+        return cached->toImage();
+    }
+    return QImage();
+}
+
+void ThumbnailCache::load(const ThumbnailKey &key, const QString &imageUrl)
+{
+    pending.insert(key);
+
+    requests->getProductImageAsync(imageUrl, this, [this, key](const QByteArray &imageData) {
+        if (imageData.isEmpty()) {
+            // Сетевую ошибку не кэшируем: при следующем показе строки картинка запросится снова
+            pending.remove(key);
+            return;
+        }
+        decode(key, imageData, false);
+    });
+}
+
+void ThumbnailCache::decode(const ThumbnailKey &key, const QByteArray &imageData, bool fromSnapshot)
+{
+    const int size = thumbnailSize;
+    auto *watcher = new QFutureWatcher<QImage>(this);
+
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, key, size, fromSnapshot]() {
+        watcher->deleteLater();
+        pending.remove(key);
+
+        // Размер успели поменять, пока картинка декодировалась: результат уже не нужен
+        if (size != thumbnailSize) {
+            return;
+        }
+
+        QImage image = watcher->result();
+        auto *pixmap = new QPixmap(QPixmap::fromImage(image));
+
+        // Битые картинки тоже кэшируются (пустым пиксмапом), чтобы не декодировать их повторно
+        const int cost = qMax(1, pixmap->width() * pixmap->height() * pixmap->depth() / 8);
+        cache.insert(key, pixmap, cost);
+        emit thumbnailReady(key.productId, key.imageHash, fromSnapshot);
+    });
+
+    watcher->setFuture(QtConcurrent::run(&pool, [imageData, size]() {
+        Metrics::ScopedTimer timer("ui: image decode");
+        QImage image;
+        image.loadFromData(imageData);
+        if (image.isNull()) {
+            return image;
+        }
+        return image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }));
+}
@@ -0,0 +1,69 @@
+#ifndef HTTP_CLIENT_THUMBNAILCACHE_H
+#define HTTP_CLIENT_THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QSet>
+#include <QPixmap>
+#include <QThreadPool>
+#include <QPair>
+
+// Миниатюра однозначно определяется товаром и содержимым картинки:
+// после пересортировки или поиска та же картинка не декодируется повторно
+struct ThumbnailKey
+{
+    int productId;
+    uint imageHash;
+
+    bool operator==(const ThumbnailKey &other) const
+    {
+        return productId == other.productId && imageHash == other.imageHash;
+    }
+};
+
+inline uint qHash(const ThumbnailKey &key, uint seed = 0)
+{
+    return qHash(qMakePair(key.productId, key.imageHash), seed);
+}
+
+class Requests;
+class CatalogSnapshot;
+
+// Миниатюры товаров: картинка скачивается через Requests (с дисковым HTTP-кэшем), декодирование идёт в пуле потоков (QImage), в пиксмап картинка
+// превращается уже в GUI-потоке. Готовые миниатюры лежат в LRU-кэше с ограничением по байтам.
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThumbnailCache(Requests *requests, QObject *parent = nullptr);
+    ~ThumbnailCache();
+
+    void setThumbnailSize(int size);
+    void setMaxBytes(int bytes) { cache.setMaxCost(bytes); }
+
+    // Возвращает миниатюру из кэша; если её нет, ставит декодирование в очередь и возвращает пустой пиксмап
+    QPixmap thumbnail(int productId, uint imageHash, const QString &imageUrl);
+    // Миниатюра из кэша для сохранения в снимок; пустая, если её нет
+    QImage image(const ThumbnailKey &key) const;
+    // Миниатюры из снимка берутся без сети: сжатые данные из файла сразу уходят на декодирование
+    void setSnapshot(const CatalogSnapshot *snapshot) { this->snapshot = snapshot; }
+    int size() const { return thumbnailSize; }
+
+signals:
+    // fromSnapshot - картинка уже есть в снимке на диске, перезаписывать его ради неё не нужно
+    void thumbnailReady(int productId, uint imageHash, bool fromSnapshot);
+
+private:
+    void load(const ThumbnailKey &key, const QString &imageUrl);
+    void decode(const ThumbnailKey &key, const QByteArray &imageData, bool fromSnapshot);
+
+    Requests *requests;
+    const CatalogSnapshot *snapshot = nullptr;
+    QCache<ThumbnailKey, QPixmap> cache;
+    QSet<ThumbnailKey> pending;
+    QThreadPool pool;
+    int thumbnailSize = 250;
+};
+
+#endif //HTTP_CLIENT_THUMBNAILCACHE_H
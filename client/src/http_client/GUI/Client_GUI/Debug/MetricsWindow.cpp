@@ -0,0 +1,105 @@
+#include "MetricsWindow.h"
+#include "http_client/metrics/Metrics.h"
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+MetricsWindow::MetricsWindow(QWidget *parent) : QWidget(parent, Qt::Tool)
+{
+    setWindowTitle("Метрики клиента");
+    resize(820, 420);
+
+    table = new QTableWidget(0, 7, this);
+    table->setHorizontalHeaderLabels({"Метрика", "Кол-во", "Среднее, мс", "p50, мс", "p90, мс", "p99, мс", "Макс, мс"});
+    table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    table->verticalHeader()->hide();
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    auto *saveButton = new QPushButton("Сохранить JSON", this);
+    auto *resetButton = new QPushButton("Сбросить", this);
+    connect(saveButton, &QPushButton::clicked, this, &MetricsWindow::onSaveClicked);
+    connect(resetButton, &QPushButton::clicked, this, &MetricsWindow::onResetClicked);
+
+    auto *buttons = new QHBoxLayout;
+    buttons->addWidget(saveButton);
+    buttons->addWidget(resetButton);
+    buttons->addStretch();
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(buttons);
+    layout->addWidget(table);
+
+    // Таблица обновляется, только пока окно видно
+    refreshTimer = new QTimer(this);
+    refreshTimer->setInterval(RefreshIntervalMs);
+    connect(refreshTimer, &QTimer::timeout, this, &MetricsWindow::refresh);
+}
+
+void MetricsWindow::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+    refreshTimer->start();
+}
+
+void MetricsWindow::hideEvent(QHideEvent *event)
+{
+    refreshTimer->stop();
+    QWidget::hideEvent(event);
+}
+
+void MetricsWindow::refresh()
+{
+    const QMap<QString, LatencyHistogram::Summary> summaries = Metrics::shared().summaries();
+
+    table->setRowCount(summaries.size());
+    int row = 0;
+    for (auto it = summaries.constBegin(); it != summaries.constEnd(); ++it, ++row)
+    {
+        const LatencyHistogram::Summary &summary = it.value();
+        const QStringList cells = {
+                it.key(),
+                QString::number(summary.count),
+                QString::number(summary.meanMs, 'f', 2),
+                QString::number(summary.p50Ms, 'f', 2),
+                QString::number(summary.p90Ms, 'f', 2),
+                QString::number(summary.p99Ms, 'f', 2),
+                QString::number(summary.maxMs, 'f', 2)
+        };
+        for (int column = 0; column < cells.size(); ++column)
+        {
+            QTableWidgetItem *item = table->item(row, column);
+            if (!item)
+            {
+                item = new QTableWidgetItem;
+                item->setTextAlignment(column == 0 ? int(Qt::AlignLeft | Qt::AlignVCenter)
+                                                   : int(Qt::AlignRight | Qt::AlignVCenter));
+                table->setItem(row, column, item);
+            }
+            item->setText(cells.at(column));
+        }
+    }
+}
+
+void MetricsWindow::onSaveClicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Сохранить метрики", "metrics.json", "JSON Files (*.json)");
+    if (fileName.isEmpty()) return;
+
+    if (!Metrics::shared().writeJson(fileName))
+    {
+        QMessageBox::warning(this, "Ошибка", "Не удалось сохранить метрики");
+    }
+}
+
+void MetricsWindow::onResetClicked()
+{
+    Metrics::shared().reset();
+    refresh();
+}
@@ -0,0 +1,34 @@
+#ifndef METRICSWINDOW_H
+#define METRICSWINDOW_H
+
+#include <QWidget>
+
+class QTableWidget;
+class QTimer;
+
+// Служебное окно с метриками клиента (Metrics): задержки запросов к серверу по фазам
+// и время перестроения моделей и декодирования картинок. Открывается сочетанием Ctrl+Shift+M
+class MetricsWindow : public QWidget
+{
+Q_OBJECT
+
+public:
+    explicit MetricsWindow(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+    void onSaveClicked();
+    void onResetClicked();
+
+private:
+    QTableWidget *table;
+    QTimer *refreshTimer;
+
+    static const int RefreshIntervalMs = 1000;
+};
+
+#endif // METRICSWINDOW_H
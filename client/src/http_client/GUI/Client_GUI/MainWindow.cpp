@@ -1,25 +1,39 @@
 #include "MainWindow.h"
+#include <QCloseEvent>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QTableWidgetItem>
+#include <QHeaderView>
 #include <QMessageBox>
 #include <QInputDialog>
+#include <QShortcut>
+#include <QStatusBar>
 
 #include "http_client/GUI/Login_GUI/UserSession.h"
+#include "http_client/metrics/Metrics.h"
 
 MainWindow::MainWindow(QWidget *parent)
         : QMainWindow(parent),
           ui(new Ui::MainWindowCustomer),
           requests(new Requests(this)),
+          productModel(new ProductTableModel(requests, this)),
+          proxyModel(new ProductSortFilterProxyModel(productModel, this)),
+          searchIndex(new ProductSearchIndex(productModel, this)),
+          catalogSyncTimer(new QTimer(this)),
           editProfileWindow(nullptr)
 {
     ui->setupUi(this);
+    setupTable();
     setupConnections();
-    updateTable();
-
-    ui->tableWidget->setSelectionMode(QAbstractItemView::SingleSelection);
-    ui->tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
+    setupCart();
+    setupEvents();
+    // Каталог из снимка показывается сразу, а свежесть проверяется у сервера в фоне
+    if (productModel->restoreSnapshot()) {
+        catalogAge.start();
+        productModel->revalidate();
+    } else {
+        updateTable();
+    }
 
     ui->comboBox->addItem("По номеру", "id");
     ui->comboBox->addItem("По названию", "name");
@@ -35,6 +49,26 @@ MainWindow::~MainWindow()
     delete editProfileWindow;
 }
 
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    // Неотправленные изменения корзины иначе пропадут вместе с окном. Окно прячется сразу,
+    // а закрывается (и завершает приложение), когда очередь опустеет или сервер так и не ответит
+    if (cartQueue && !cartQueue->isIdle() && !closingAfterFlush) {
+        closingAfterFlush = true;
+        event->ignore();
+        hide();
+        connect(cartQueue, &CartOperationQueue::pendingChanged, this, [this]() {
+            if (cartQueue->isIdle()) {
+                close();
+            }
+        });
+        QTimer::singleShot(CartFlushOnExitMs, this, &MainWindow::close);
+        cartQueue->flush();
+        return;
+    }
+    QMainWindow::closeEvent(event);
+}
+
 void MainWindow::setupConnections()
 {
     connect(ui->pushButton_Change_info_user, &QPushButton::clicked, this, &MainWindow::edit_profile);
@@ -45,45 +79,197 @@ void MainWindow::setupConnections()
     connect(ui->pushButton_exit, &QPushButton::clicked, this, &MainWindow::Exit);
     connect(ui->pushButton_sort_products, &QPushButton::clicked, this, &MainWindow::SortProducts);
     connect(ui->pushButton_add_to_cart, &QPushButton::clicked, this, &MainWindow::onAddToCartClicked);
+    connect(productModel, &ProductTableModel::loadFailed, this, [this]() {
+        QMessageBox::warning(this, "Ошибка", "Не удалось загрузить товары");
+    });
+
+    // Поиск локальный, поэтому выполняется прямо при вводе
+    connect(ui->textEdit_find_product, &QTextEdit::textChanged, this, &MainWindow::runSearch);
+    // Дозагруженные страницы тоже должны пройти через активный поиск
+    connect(productModel, &QAbstractItemModel::rowsInserted, this, &MainWindow::runSearch);
+    connect(productModel, &QAbstractItemModel::modelReset, this, &MainWindow::runSearch);
+    connect(productModel, &ProductTableModel::catalogPatched, this, &MainWindow::runSearch);
+
+    // Служебное окно метрик; работает из любого окна приложения
+    auto *metricsShortcut = new QShortcut(QKeySequence("Ctrl+Shift+M"), this);
+    metricsShortcut->setContext(Qt::ApplicationShortcut);
+    connect(metricsShortcut, &QShortcut::activated, this, &MainWindow::toggleMetricsWindow);
+
+    // Дельта занимает столько байт, сколько изменилось, поэтому опрашивать сервер можно часто
+    catalogSyncTimer->setInterval(CatalogSyncIntervalMs);
+    connect(catalogSyncTimer, &QTimer::timeout, this, [this]() {
+        if (productModel->revalidate()) {
+            catalogAge.start();
+        }
+    });
+    catalogSyncTimer->start();
 }
 
-void MainWindow::initializingTable(const QJsonArray &data)
+void MainWindow::setupEvents()
 {
-    ui->tableWidget->clearContents();
-    ui->tableWidget->setRowCount(0);
+    const int customerId = UserSession::instance().getCustomerId();
+    if (customerId <= 0) {
+        return;
+    }
 
-    QStringList headers = {"ID", "Фото", "Название", "Оптовая цена", "Розничная цена", "Описание"};
-    ui->tableWidget->setColumnCount(headers.size());
-    ui->tableWidget->setHorizontalHeaderLabels(headers);
-    ui->tableWidget->setRowCount(data.size());
+    events = requests->customerEvents(customerId, this);
+    connect(events, &EventStream::eventReceived, this, &MainWindow::onServerEvent);
 
-    const int imageSize = 250;
-    int row = 0;
+    // Пока сервер присылает события, опрашивать его не нужно; на время обрыва опрос возвращается
+    connect(events, &EventStream::connected, this, [this]() {
+        catalogSyncTimer->stop();
+        // Пока соединения не было, события могли потеряться
+        productModel->revalidate();
+        if (cartWindow) {
+            cartWindow->loadCart();
+        }
+    });
+    connect(events, &EventStream::disconnected, catalogSyncTimer, QOverload<>::of(&QTimer::start));
+
+    events->start();
+}
 
-    for (const QJsonValue &value : data) {
-        QJsonObject item = value.toObject();
+void MainWindow::onServerEvent(const QString &type, const QByteArray &data)
+{
+    if (type == "catalog") {
+        // Само событие несёт только версию; изменённые товары приходят дельтой
+        productModel->revalidate();
+    } else if (type == "cart") {
+        Dto::Cart cart;
+        if (Requests::parseCart(data, cart)) {
+            setConfirmedCart(cart);
+        }
+    } else if (type == "resync") {
+        productModel->revalidate();
+        if (cartWindow) {
+            cartWindow->loadCart();
+        }
+    }
+}
 
-        ui->tableWidget->setItem(row, 0, new QTableWidgetItem(QString::number(item["ProductID"].toInt())));
+void MainWindow::setupCart()
+{
+    const int customerId = UserSession::instance().getCustomerId();
+    if (customerId <= 0) {
+        return;
+    }
 
-        if (item.contains("Image") && !item["Image"].isNull()) {
-            QTableWidgetItem *photoItem = createPhotoTableItem(item["Image"].toString(), imageSize);
-            ui->tableWidget->setItem(row, 1, photoItem);
+    cartQueue = new CartOperationQueue(requests, customerId, this);
+    connect(cartQueue, &CartOperationQueue::pendingChanged, this, &MainWindow::updateCartColumn);
+    connect(cartQueue, &CartOperationQueue::flushed, this, [this](const Dto::Cart &cart) {
+        setConfirmedCart(cart);
+        statusBar()->showMessage("Корзина сохранена", 3000);
+    });
+    connect(cartQueue, &CartOperationQueue::failed, this, [this](int productCount) {
+        statusBar()->showMessage(QString("Не удалось сохранить изменения корзины (товаров: %1)").arg(productCount), 5000);
+        // Отброшенные изменения уже убраны из колонки; сверяемся с сервером на случай частичного успеха
+        requests->getCartAsync(UserSession::instance().getCustomerId(), this, [this](bool ok, const Dto::Cart &cart) {
+            if (ok) {
+                setConfirmedCart(cart);
+            }
+        });
+    });
+
+    // Delete убирает одну штуку выбранного товара из корзины
+    auto *removeShortcut = new QShortcut(QKeySequence::Delete, ui->tableView);
+    connect(removeShortcut, &QShortcut::activated, this, &MainWindow::removeSelectedFromCart);
+
+    requests->getCartAsync(customerId, this, [this](bool ok, const Dto::Cart &cart) {
+        if (ok) {
+            setConfirmedCart(cart);
         }
+    });
+}
+
+void MainWindow::setConfirmedCart(const Dto::Cart &cart)
+{
+    cartQuantities.clear();
+    for (const Dto::CartItem &item : cart.items) {
+        cartQuantities[item.productId] += item.quantity;
+    }
+    updateCartColumn();
+
+    if (cartWindow) {
+        cartWindow->showCart(cart);
+    }
+}
 
-        ui->tableWidget->setItem(row, 2, new QTableWidgetItem(item["Name"].toString()));
-        ui->tableWidget->setItem(row, 3, new QTableWidgetItem(QString::number(item["WholesalePrice"].toDouble(), 'f', 2) + " ₽"));
-        ui->tableWidget->setItem(row, 4, new QTableWidgetItem(QString::number(item["RetailPrice"].toDouble(), 'f', 2) + " ₽"));
-        ui->tableWidget->setItem(row, 5, new QTableWidgetItem(item["Description"].toString()));
+void MainWindow::updateCartColumn()
+{
+    // В колонке сразу видно нажатие, не дожидаясь сервера: к подтверждённому количеству
+    // добавляются изменения из очереди
+    QHash<int, int> quantities = cartQuantities;
+    QSet<int> unconfirmed;
+    if (cartQueue) {
+        const QHash<int, int> pending = cartQueue->pending();
+        for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+            quantities[it.key()] = qMax(0, quantities.value(it.key()) + it.value());
+            unconfirmed.insert(it.key());
+        }
+    }
+    productModel->setCartQuantities(quantities, unconfirmed);
+}
 
-        row++;
+void MainWindow::removeSelectedFromCart()
+{
+    QModelIndexList selected = ui->tableView->selectionModel()->selectedRows();
+    if (!cartQueue || selected.isEmpty()) {
+        return;
     }
 
-    ui->tableWidget->resizeColumnsToContents();
-    ui->tableWidget->setColumnWidth(1, imageSize);
-    ui->tableWidget->resizeRowsToContents();
+    const int productId = proxyModel->productId(selected.first().row());
+    const int inCart = cartQuantities.value(productId) + cartQueue->pending().value(productId);
+    if (inCart <= 0) {
+        return;
+    }
 
-    ui->tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
-    ui->tableWidget->setSelectionMode(QAbstractItemView::SingleSelection);
+    cartQueue->add(productId, -1);
+    statusBar()->showMessage("Товар убран из корзины", 3000);
+}
+
+void MainWindow::setupTable()
+{
+    const int imageSize = 250;
+
+    productModel->setImageSize(imageSize);
+    ui->tableView->setModel(proxyModel);
+
+    ui->tableView->setSelectionMode(QAbstractItemView::SingleSelection);
+    ui->tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    ui->tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    ui->tableView->setWordWrap(false);
+
+    // Одинаковая высота строк: представлению не нужно измерять содержимое, чтобы прокручивать таблицу
+    QHeaderView *rows = ui->tableView->verticalHeader();
+    rows->setSectionResizeMode(QHeaderView::Fixed);
+    rows->setDefaultSectionSize(imageSize);
+    rows->hide();
+
+    QHeaderView *columns = ui->tableView->horizontalHeader();
+    columns->resizeSection(ProductTableModel::IdColumn, 60);
+    columns->resizeSection(ProductTableModel::PhotoColumn, imageSize);
+    columns->resizeSection(ProductTableModel::NameColumn, 220);
+    columns->resizeSection(ProductTableModel::WholesalePriceColumn, 120);
+    columns->resizeSection(ProductTableModel::RetailPriceColumn, 120);
+    columns->resizeSection(ProductTableModel::InCartColumn, 90);
+    columns->setStretchLastSection(true);
+    columns->setSortIndicator(-1, Qt::AscendingOrder);
+    ui->tableView->setSortingEnabled(true);
+}
+
+void MainWindow::toggleMetricsWindow()
+{
+    if (!metricsWindow) {
+        metricsWindow = new MetricsWindow(this);
+    }
+
+    if (metricsWindow->isVisible()) {
+        metricsWindow->hide();
+        return;
+    }
+    metricsWindow->show();
+    metricsWindow->raise();
+    metricsWindow->activateWindow();
 }
 
 void MainWindow::SortProducts()
@@ -105,35 +291,39 @@ void MainWindow::SortProducts()
         lastField = selectedField;
     }
 
-    QJsonArray sortedResults = requests->getSortedProducts(selectedField, isAscending ? "asc" : "desc");
-
-    if (sortedResults.isEmpty()) {
-        QMessageBox::information(this, "Сортировка", "Нет данных для отображения");
-        return;
+    static const QHash<QString, int> columns = {
+            {"id", ProductTableModel::IdColumn},
+            {"name", ProductTableModel::NameColumn},
+            {"wholesale_price", ProductTableModel::WholesalePriceColumn},
+            {"retail_price", ProductTableModel::RetailPriceColumn},
+            {"description", ProductTableModel::DescriptionColumn}
+    };
+
+    // Сервер нужен, только если каталог устарел; иначе сортируем уже загруженные товары
+    if (catalogAge.isValid() && catalogAge.hasExpired(CatalogMaxAgeMs)) {
+        refreshCatalog();
     }
 
-    initializingTable(sortedResults);
+    // Сортировать нужно весь каталог, а не только прокрученные страницы
+    productModel->fetchAll();
+    Metrics::ScopedTimer timer("ui: catalog sort");
+    ui->tableView->sortByColumn(columns.value(selectedField), isAscending ? Qt::AscendingOrder : Qt::DescendingOrder);
 }
 
-QTableWidgetItem* MainWindow::createPhotoTableItem(const QString &base64String, int size)
+void MainWindow::updateTable()
 {
-    QByteArray imageData = QByteArray::fromBase64(base64String.toUtf8());
-    QPixmap pixmap;
-    pixmap.loadFromData(imageData);
-
-    QTableWidgetItem *item = new QTableWidgetItem();
-    item->setData(Qt::DecorationRole, pixmap.scaled(size, size, Qt::KeepAspectRatio));
-    return item;
+    catalogAge.start();
+    productModel->reload();
 }
 
-void MainWindow::updateTable()
+void MainWindow::refreshCatalog()
 {
-    QJsonArray products = requests->getAllProducts();
-    if (products.isEmpty()) {
-        QMessageBox::warning(this, "Ошибка", "Не удалось загрузить товары");
-        return;
+    // Полный каталог догоняется по изменениям на месте; частично загруженный проще запросить заново
+    if (productModel->revalidate()) {
+        catalogAge.start();
+    } else {
+        updateTable();
     }
-    initializingTable(products);
 }
 
 void MainWindow::FindProducts()
@@ -145,19 +335,46 @@ void MainWindow::FindProducts()
         return;
     }
 
-    QJsonArray results = requests->searchProducts(searchText);
-    if (results.isEmpty()) {
+    runSearch();
+
+    // Пока каталог догружается, результаты ещё могут появиться
+    if (productModel->isComplete() && proxyModel->rowCount() == 0) {
         QMessageBox::information(this, "Поиск", "Товары не найдены");
+    }
+}
+
+void MainWindow::runSearch()
+{
+    QString searchText = ui->textEdit_find_product->toPlainText().trimmed();
+
+    if (searchText.isEmpty()) {
+        proxyModel->clearSearch();
         return;
     }
 
-    initializingTable(results);
+    // Искать нужно по всему каталогу, а не только по прокрученным страницам
+    productModel->fetchAll();
+
+    Metrics::ScopedTimer timer("ui: catalog search");
+    QVector<int> scores(productModel->products().size(), -1);
+    for (const ProductSearchIndex::Match &match : searchIndex->search(searchText)) {
+        scores[match.row] = match.score;
+    }
+    proxyModel->setSearchScores(scores);
+
+    // Если пользователь сам выбрал колонку, его сортировку не трогаем
+    if (ui->tableView->horizontalHeader()->sortIndicatorSection() < 0) {
+        proxyModel->sortByRelevance();
+    }
 }
 
 void MainWindow::ResetFilters()
 {
     ui->textEdit_find_product->clear();
+    proxyModel->clearSearch();
     ui->comboBox->setCurrentIndex(0);
+    proxyModel->sort(-1);
+    ui->tableView->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
     updateTable();
 }
 
@@ -176,16 +393,17 @@ void MainWindow::edit_profile()
                 this, &MainWindow::handleProfileUpdate);
     }
 
-    QJsonObject customerData = requests->getCustomerInfo(session.getCustomerId());
-    if (customerData.isEmpty()) {
-        QMessageBox::warning(this, "Ошибка", "Не удалось загрузить данные профиля");
-        return;
-    }
+    requests->getCustomerInfoAsync(session.getCustomerId(), this, [this](const QJsonObject &customerData) {
+        if (customerData.isEmpty()) {
+            QMessageBox::warning(this, "Ошибка", "Не удалось загрузить данные профиля");
+            return;
+        }
 
-    editProfileWindow->setProfileData(customerData);
-    editProfileWindow->show();
-    editProfileWindow->raise();
-    editProfileWindow->activateWindow();
+        editProfileWindow->setProfileData(customerData);
+        editProfileWindow->show();
+        editProfileWindow->raise();
+        editProfileWindow->activateWindow();
+    });
 }
 
 
@@ -204,23 +422,25 @@ void MainWindow::handleProfileUpdate(const QString &name,
 
     qDebug() << "Sending updated data:" << updatedData;
 
-    bool success = requests->updateCustomerInfo(UserSession::instance().getCustomerId(), updatedData);
-    if (!success) {
-        QMessageBox::warning(this, "Ошибка", "Не удалось обновить данные профиля");
-        return;
-    }
+    requests->updateCustomerInfoAsync(UserSession::instance().getCustomerId(), updatedData, this,
+                                      [this, name, phone, contacts, address, email](bool success) {
+        if (!success) {
+            QMessageBox::warning(this, "Ошибка", "Не удалось обновить данные профиля");
+            return;
+        }
 
-    // Обновляем данные в сессии
-    UserSession::instance().setCustomerData(
-            UserSession::instance().getCustomerId(),
-            name,
-            email,
-            phone,
-            address,
-            contacts
-    );
-
-    QMessageBox::information(this, "Успех", "Профиль успешно обновлён");
+        // Обновляем данные в сессии
+        UserSession::instance().setCustomerData(
+                UserSession::instance().getCustomerId(),
+                name,
+                email,
+                phone,
+                address,
+                contacts
+        );
+
+        QMessageBox::information(this, "Успех", "Профиль успешно обновлён");
+    });
 }
 
 void MainWindow::open_cart_customer()
@@ -237,7 +457,7 @@ void MainWindow::open_cart_customer()
         cartWindow = nullptr;
     }
 
-    cartWindow = new CartWindow(requests);
+    cartWindow = new CartWindow(requests, cartQueue);
     cartWindow->setAttribute(Qt::WA_DeleteOnClose);
 
     connect(this, &MainWindow::cartUpdated, cartWindow, &CartWindow::loadCart);
@@ -253,15 +473,22 @@ void MainWindow::open_cart_customer()
 
 void MainWindow::open_orders_customer()
 {
-    int currentUserId = 1;
-    QJsonArray orders = requests->getOrders(currentUserId);
+    const int currentUserId = UserSession::instance().getCustomerId();
 
-    if (orders.isEmpty()) {
-        QMessageBox::information(this, "Заказы", "У вас нет заказов");
+    if (currentUserId <= 0) {
+        QMessageBox::warning(this, "Ошибка", "Пользователь не авторизован");
         return;
     }
 
-    initializingTable(orders);
+    // Открытое окно уже листает историю: показываем его, а не загружаем всё заново
+    if (!ordersWindow) {
+        ordersWindow = new OrdersWindow(requests, currentUserId);
+        ordersWindow->setAttribute(Qt::WA_DeleteOnClose);
+    }
+
+    ordersWindow->show();
+    ordersWindow->raise();
+    ordersWindow->activateWindow();
 }
 
 void MainWindow::onAddToCartClicked()
@@ -271,23 +498,21 @@ void MainWindow::onAddToCartClicked()
         return;
     }
 
-    QList<QTableWidgetItem*> selected = ui->tableWidget->selectedItems();
+    QModelIndexList selected = ui->tableView->selectionModel()->selectedRows();
     if (selected.isEmpty()) {
         QMessageBox::warning(this, "Ошибка", "Выберите товар");
         return;
     }
 
-    int row = selected.first()->row();
-    int productId = ui->tableWidget->item(row, 0)->text().toInt();
-
-    QJsonObject response = requests->addToCart(UserSession::instance().getCustomerId(), productId, 1);
-
-    if (response.isEmpty()) {
-        QMessageBox::warning(this, "Ошибка", "Не удалось добавить товар в корзину");
-    } else {
-        QMessageBox::information(this, "Успешно", "Товар добавлен в корзину");
-        emit cartUpdated();
+    int productId = proxyModel->productId(selected.first().row());
+    if (!cartQueue) {
+        return;
     }
+
+    // Товар сразу виден в колонке "В корзине", а на сервер уходит пакетом вместе с соседними нажатиями
+    cartQueue->add(productId, 1);
+    const int row = productModel->products().rowOf(productId);
+    statusBar()->showMessage(QString("«%1» добавлен в корзину").arg(productModel->products().name(row)), 3000);
 }
 
 void MainWindow::Exit()
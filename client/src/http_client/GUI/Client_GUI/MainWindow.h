@@ -1,11 +1,19 @@
 #ifndef HTTP_CLIENT_CLIENT_FORM_H
 #define HTTP_CLIENT_CLIENT_FORM_H
 
-#include <QTableWidgetItem>
 #include "http_client/http_requests/Requests.h"
+#include "http_client/http_requests/CartOperationQueue.h"
 #include "ui_MainWindow.h"
 #include "../Client_GUI/Profile/EditProfileWindow.h"
 #include "../Client_GUI/Cart/CartWindow.h"
+#include "../Client_GUI/Orders/OrdersWindow.h"
+#include "../Client_GUI/Debug/MetricsWindow.h"
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+#include "../Client_GUI/Catalog/ProductTableModel.h"
+#include "../Client_GUI/Catalog/ProductSortFilterProxyModel.h"
+#include "../Client_GUI/Catalog/ProductSearchIndex.h"
 
 class MainWindow : public QMainWindow
 {
@@ -34,18 +42,43 @@ public slots:
 signals:
     void loggedOut();
 
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
 private:
     EditProfileWindow *editProfileWindow;
     Ui_MainWindowCustomer *ui;
-    CartWindow* cartWindow = nullptr;
+    QPointer<CartWindow> cartWindow; // окно удаляется само при закрытии
+    QPointer<OrdersWindow> ordersWindow;
+    MetricsWindow *metricsWindow = nullptr; // создаётся при первом открытии
     Requests *requests;
+    ProductTableModel *productModel;
+    ProductSortFilterProxyModel *proxyModel;
+    ProductSearchIndex *searchIndex;
+    EventStream *events = nullptr; // события сервера для вошедшего покупателя
+    CartOperationQueue *cartQueue = nullptr; // изменения корзины, ещё не отправленные пакетом
+    QHash<int, int> cartQuantities; // содержимое корзины по последнему ответу сервера
+    bool closingAfterFlush = false; // окно спрятано и закроется, когда изменения корзины уйдут на сервер
+    static const int CartFlushOnExitMs = 2000;
 
     QString currentSortField;
+    QElapsedTimer catalogAge; // время с последней загрузки каталога с сервера
+    static const qint64 CatalogMaxAgeMs = 5 * 60 * 1000;
+    QTimer *catalogSyncTimer; // периодически догоняет каталог по изменениям на сервере
+    static const int CatalogSyncIntervalMs = 60 * 1000;
 
     void updateTable();
-    void initializingTable(const QJsonArray &);
+    void refreshCatalog();
     void setupConnections();
-    QTableWidgetItem* createPhotoTableItem(const QString &base64String, int newSize);
+    void toggleMetricsWindow();
+    void setupEvents();
+    void setupCart();
+    void setConfirmedCart(const Dto::Cart &cart);
+    void updateCartColumn();
+    void removeSelectedFromCart();
+    void onServerEvent(const QString &type, const QByteArray &data);
+    void setupTable();
+    void runSearch();
 };
 
 #endif //HTTP_CLIENT_CLIENT_FORM_H
@@ -0,0 +1,271 @@
+#include "OrderHistoryModel.h"
+#include <QDateTime>
+#include <QFont>
+#include "http_client/http_requests/Requests.h"
+
+// internalId индекса: 0 - строка заказа, иначе номер строки заказа + 1 для строк его товаров.
+// Заказы только дописываются в конец (кроме reload), поэтому номер строки заказа не меняется
+static const quintptr TopLevel = 0;
+
+OrderHistoryModel::OrderHistoryModel(Requests *requests, int customerId, QObject *parent)
+        : QAbstractItemModel(parent), requests(requests), customerId(customerId)
+{
+}
+
+void OrderHistoryModel::reload()
+{
+    beginResetModel();
+    ++generation;
+    orders.clear();
+    nextCursor.clear();
+    hasMorePages = true;
+    fetching = false;
+    endResetModel();
+
+    requestPage();
+}
+
+int OrderHistoryModel::orderId(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return 0;
+    }
+    const int row = index.internalId() == TopLevel ? index.row() : int(index.internalId() - 1);
+    return orders.at(row).summary.id;
+}
+
+QModelIndex OrderHistoryModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent)) {
+        return QModelIndex();
+    }
+    if (!parent.isValid()) {
+        return createIndex(row, column, TopLevel);
+    }
+    return createIndex(row, column, quintptr(parent.row() + 1));
+}
+
+QModelIndex OrderHistoryModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid() || child.internalId() == TopLevel) {
+        return QModelIndex();
+    }
+    return createIndex(int(child.internalId() - 1), 0, TopLevel);
+}
+
+int OrderHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return orders.size();
+    }
+    if (parent.internalId() != TopLevel || parent.column() != 0) {
+        return 0;
+    }
+    return orders.at(parent.row()).details.size();
+}
+
+int OrderHistoryModel::columnCount(const QModelIndex &) const
+{
+    return ColumnCount;
+}
+
+bool OrderHistoryModel::hasChildren(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return true;
+    }
+    // Стрелка разворачивания видна до загрузки товаров: их число известно из заголовка
+    return parent.internalId() == TopLevel && parent.column() == 0 && orders.at(parent.row()).summary.itemCount > 0;
+}
+
+QVariant OrderHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    if (index.internalId() == TopLevel) {
+        return orderData(orders.at(index.row()), index.column(), role);
+    }
+    const Order &order = orders.at(int(index.internalId() - 1));
+    return detailData(order.details.at(index.row()), index.column(), role);
+}
+
+QVariant OrderHistoryModel::orderData(const Order &order, int column, int role) const
+{
+    const Dto::OrderSummary &summary = order.summary;
+
+    if (role == Qt::FontRole) {
+        QFont font;
+        font.setBold(true);
+        return font;
+    }
+
+    if (role == Qt::TextAlignmentRole && column != OrderColumn && column != DateColumn) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (column) {
+        case OrderColumn:
+            return QString("Заказ #%1 (%2)").arg(summary.id).arg(summary.isWholesale ? "оптовый" : "розничный");
+        case DateColumn: {
+            const QDateTime date = QDateTime::fromString(summary.transactionDate, Qt::ISODateWithMs);
+            return date.isValid() ? date.toString("dd.MM.yyyy hh:mm") : summary.transactionDate;
+        }
+        case QuantityColumn:
+            return summary.totalQuantity;
+        case DiscountColumn:
+            return QString::number(summary.discountAmount, 'f', 2);
+        case TotalColumn:
+            return QString::number(summary.totalAmount, 'f', 2);
+        default:
+            return QVariant();
+    }
+}
+
+QVariant OrderHistoryModel::detailData(const Dto::TransactionDetail &detail, int column, int role) const
+{
+    if (role == Qt::TextAlignmentRole && column != OrderColumn) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (column) {
+        case OrderColumn:
+            return detail.productName;
+        case QuantityColumn:
+            return detail.quantity;
+        case PriceColumn:
+            return QString::number(detail.currentPrice, 'f', 2);
+        case DiscountColumn:
+            return QString("%1%").arg(detail.discount * 100, 0, 'f', 1);
+        case TotalColumn:
+            return QString::number(detail.calculatedTotal, 'f', 2);
+        default:
+            return QVariant();
+    }
+}
+
+QVariant OrderHistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (section) {
+        case OrderColumn:
+            return QString("Заказ / товар");
+        case DateColumn:
+            return QString("Дата");
+        case QuantityColumn:
+            return QString("Кол-во");
+        case PriceColumn:
+            return QString("Цена");
+        case DiscountColumn:
+            return QString("Скидка");
+        case TotalColumn:
+            return QString("Сумма");
+        default:
+            return QVariant();
+    }
+}
+
+bool OrderHistoryModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return hasMorePages && !fetching;
+    }
+    if (parent.internalId() != TopLevel) {
+        return false;
+    }
+    const Order &order = orders.at(parent.row());
+    return order.summary.itemCount > 0 && !order.detailsLoaded && !order.detailsLoading;
+}
+
+void OrderHistoryModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    if (!parent.isValid()) {
+        requestPage();
+    } else {
+        requestDetails(parent.row());
+    }
+}
+
+void OrderHistoryModel::requestPage()
+{
+    fetching = true;
+    const int requestGeneration = generation;
+
+    requests->getOrdersAsync(customerId, nextCursor, PageSize, this,
+                             [this, requestGeneration](bool ok, const Dto::OrdersPage &page) {
+        if (requestGeneration != generation) {
+            return;
+        }
+
+        const bool first = orders.isEmpty();
+        fetching = false;
+        if (!ok) {
+            // Следующую попытку сделает представление при очередной прокрутке
+            if (first) {
+                hasMorePages = false;
+                emit loadFailed();
+            }
+            return;
+        }
+
+        nextCursor = page.nextCursor;
+        hasMorePages = !nextCursor.isEmpty();
+        if (!page.orders.isEmpty()) {
+            beginInsertRows(QModelIndex(), orders.size(), orders.size() + page.orders.size() - 1);
+            for (const Dto::OrderSummary &summary : page.orders) {
+                Order order;
+                order.summary = summary;
+                orders.append(order);
+            }
+            endInsertRows();
+        }
+
+        if (first) {
+            emit firstPageLoaded();
+        }
+    });
+}
+
+void OrderHistoryModel::requestDetails(int row)
+{
+    orders[row].detailsLoading = true;
+    const int requestGeneration = generation;
+    const int id = orders.at(row).summary.id;
+
+    requests->getOrderAsync(id, this, [this, requestGeneration, row](bool ok, const Dto::Transaction &order) {
+        // В пределах одного поколения строки заказов не сдвигаются
+        if (requestGeneration != generation) {
+            return;
+        }
+
+        Order &target = orders[row];
+        target.detailsLoading = false;
+        if (!ok) {
+            // Повторный запрос - при следующем разворачивании
+            return;
+        }
+
+        target.detailsLoaded = true;
+        if (order.details.isEmpty()) {
+            return;
+        }
+        beginInsertRows(index(row, 0), 0, order.details.size() - 1);
+        target.details = order.details;
+        endInsertRows();
+    });
+}
@@ -0,0 +1,77 @@
+#ifndef HTTP_CLIENT_ORDERHISTORYMODEL_H
+#define HTTP_CLIENT_ORDERHISTORYMODEL_H
+
+#include <QAbstractItemModel>
+#include <QVector>
+#include "http_client/http_requests/Dto.h"
+
+class Requests;
+
+// История заказов покупателя для дерева: верхний уровень - заголовки заказов с итогами,
+// дочерние строки - товары заказа. Заголовки приходят страницами по мере прокрутки,
+// а товары заказа запрашиваются, только когда его строку разворачивают.
+class OrderHistoryModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        OrderColumn, // номер заказа или название товара
+        DateColumn,
+        QuantityColumn,
+        PriceColumn,
+        DiscountColumn,
+        TotalColumn,
+        ColumnCount
+    };
+
+    OrderHistoryModel(Requests *requests, int customerId, QObject *parent = nullptr);
+
+    // Загрузить историю заново с первой страницы
+    void reload();
+
+    // Номер заказа в строке верхнего уровня (для строки товара - номер его заказа)
+    int orderId(const QModelIndex &index) const;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    static const int PageSize = 50;
+
+signals:
+    // Первая страница получена; пустая история - rowCount() == 0
+    void firstPageLoaded();
+    void loadFailed();
+
+private:
+    struct Order
+    {
+        Dto::OrderSummary summary;
+        QVector<Dto::TransactionDetail> details;
+        bool detailsLoaded = false;
+        bool detailsLoading = false;
+    };
+
+    void requestPage();
+    void requestDetails(int row);
+    QVariant orderData(const Order &order, int column, int role) const;
+    QVariant detailData(const Dto::TransactionDetail &detail, int column, int role) const;
+
+    Requests *requests;
+    int customerId;
+    QVector<Order> orders;
+    QString nextCursor;
+    bool hasMorePages = true;
+    bool fetching = false;
+    int generation = 0; // ответы на запросы до reload() отбрасываются
+};
+
+#endif //HTTP_CLIENT_ORDERHISTORYMODEL_H
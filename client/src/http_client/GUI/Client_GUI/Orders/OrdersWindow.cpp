@@ -0,0 +1,93 @@
+#include "OrdersWindow.h"
+#include <QMessageBox>
+#include <QHeaderView>
+#include <QFileDialog>
+#include "http_client/GUI/Client_GUI/Reports/ReportEngine.h"
+
+OrdersWindow::OrdersWindow(Requests* requests, int customerId, QWidget *parent) : QWidget(parent), ui(new Ui::Form_orders), model(new OrderHistoryModel(requests, customerId, this)), requests(requests), customerId(customerId)
+{
+    ui->setupUi(this);
+
+    // Дерево само запрашивает следующие страницы при прокрутке и товары заказа при разворачивании
+    ui->treeView_orders->setModel(model);
+    ui->treeView_orders->setUniformRowHeights(true);
+    ui->treeView_orders->setSelectionBehavior(QAbstractItemView::SelectRows);
+    ui->treeView_orders->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    QHeaderView *columns = ui->treeView_orders->header();
+    columns->setStretchLastSection(false);
+    columns->setSectionResizeMode(OrderHistoryModel::OrderColumn, QHeaderView::Stretch);
+    columns->resizeSection(OrderHistoryModel::DateColumn, 120);
+    columns->resizeSection(OrderHistoryModel::QuantityColumn, 70);
+    columns->resizeSection(OrderHistoryModel::PriceColumn, 90);
+    columns->resizeSection(OrderHistoryModel::DiscountColumn, 90);
+    columns->resizeSection(OrderHistoryModel::TotalColumn, 100);
+
+    connect(model, &OrderHistoryModel::firstPageLoaded, this, &OrdersWindow::onFirstPageLoaded);
+    connect(model, &OrderHistoryModel::loadFailed, this, &OrdersWindow::onLoadFailed);
+    connect(ui->pushButton_export, &QPushButton::clicked, this, &OrdersWindow::onExportClicked);
+    connect(ui->pushButton_exit, &QPushButton::clicked, this, &QWidget::close);
+
+    model->reload();
+}
+
+OrdersWindow::~OrdersWindow()
+{
+    delete ui;
+}
+
+void OrdersWindow::onFirstPageLoaded()
+{
+    if (model->rowCount() == 0)
+    {
+        QMessageBox::information(this, "Заказы", "У вас нет заказов");
+    }
+}
+
+void OrdersWindow::onLoadFailed()
+{
+    QMessageBox::warning(this, "Ошибка", "Не удалось загрузить заказы");
+}
+
+void OrdersWindow::onExportClicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Сохранить выписку", "Заказы.pdf", "PDF Files (*.pdf)");
+    if (fileName.isEmpty()) return;
+
+    ui->pushButton_export->setEnabled(false);
+    ui->pushButton_export->setText("Загрузка заказов...");
+
+    // Дерево подгружает строки заказов по одному, для выписки вся история со строками берётся одним запросом
+    requests->getOrderHistoryAsync(customerId, this, [this, fileName](bool ok, const Dto::TransactionsList &list) {
+        if (!ok)
+        {
+            finishExport();
+            QMessageBox::warning(this, "Ошибка", "Не удалось загрузить заказы");
+            return;
+        }
+        if (list.transactions.isEmpty())
+        {
+            finishExport();
+            QMessageBox::information(this, "Заказы", "У вас нет заказов");
+            return;
+        }
+
+        ReportEngine::shared().exportOrders(list.transactions, fileName, this, [this](bool ok) {
+            finishExport();
+            if (!ok)
+            {
+                QMessageBox::warning(this, "Ошибка", "Не удалось создать PDF");
+                return;
+            }
+            QMessageBox::information(this, "Готово", "Выписка по заказам сохранена");
+        }, [this](int done, int total) {
+            ui->pushButton_export->setText(QString("PDF: %1 из %2").arg(done).arg(total));
+        });
+    });
+}
+
+void OrdersWindow::finishExport()
+{
+    ui->pushButton_export->setEnabled(true);
+    ui->pushButton_export->setText("Выгрузить в PDF");
+}
@@ -0,0 +1,35 @@
+#ifndef ORDERSWINDOW_H
+#define ORDERSWINDOW_H
+
+#include <QWidget>
+#include "ui_FormOrders.h"
+#include "http_client/http_requests/Requests.h"
+#include "OrderHistoryModel.h"
+
+namespace Ui {
+    class Form_orders;
+}
+
+class OrdersWindow : public QWidget
+{
+Q_OBJECT
+
+public:
+    explicit OrdersWindow(Requests* requests, int customerId, QWidget *parent = nullptr);
+    ~OrdersWindow();
+
+private slots:
+    void onFirstPageLoaded();
+    void onLoadFailed();
+    void onExportClicked();
+
+private:
+    void finishExport();
+
+    Ui::Form_orders *ui;
+    OrderHistoryModel *model;
+    Requests* requests;
+    int customerId;
+};
+
+#endif // ORDERSWINDOW_H
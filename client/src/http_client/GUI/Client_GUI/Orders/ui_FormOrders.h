@@ -0,0 +1,63 @@
+/********************************************************************************
+** Form generated from reading UI file 'Form_orders.ui'
+**
+** Created by: Qt User Interface Compiler version 5.15.16
+**
+** WARNING! All changes made in this file will be lost when recompiling UI file!
+********************************************************************************/
+
+#ifndef UI_FORMORDERS_H
+#define UI_FORMORDERS_H
+
+#include <QtCore/QVariant>
+#include <QtWidgets/QApplication>
+#include <QtWidgets/QHeaderView>
+#include <QtWidgets/QPushButton>
+#include <QtWidgets/QTreeView>
+#include <QtWidgets/QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class Ui_Form_orders
+{
+public:
+    QPushButton *pushButton_exit;
+    QTreeView *treeView_orders;
+    QPushButton *pushButton_export;
+
+    void setupUi(QWidget *Form_orders)
+    {
+        if (Form_orders->objectName().isEmpty())
+            Form_orders->setObjectName(QString::fromUtf8("Form_orders"));
+        Form_orders->resize(760, 460);
+        pushButton_exit = new QPushButton(Form_orders);
+        pushButton_exit->setObjectName(QString::fromUtf8("pushButton_exit"));
+        pushButton_exit->setGeometry(QRect(640, 0, 113, 32));
+        treeView_orders = new QTreeView(Form_orders);
+        treeView_orders->setObjectName(QString::fromUtf8("treeView_orders"));
+        treeView_orders->setGeometry(QRect(10, 40, 741, 411));
+        pushButton_export = new QPushButton(Form_orders);
+        pushButton_export->setObjectName(QString::fromUtf8("pushButton_export"));
+        pushButton_export->setGeometry(QRect(10, 0, 181, 32));
+
+        retranslateUi(Form_orders);
+
+        QMetaObject::connectSlotsByName(Form_orders);
+    } // setupUi
+
+    void retranslateUi(QWidget *Form_orders)
+    {
+        Form_orders->setWindowTitle(QCoreApplication::translate("Form_orders", "\320\234\320\276\320\270 \320\267\320\260\320\272\320\260\320\267\321\213", nullptr));
+        pushButton_exit->setText(QCoreApplication::translate("Form_orders", "\320\222\321\213\320\271\321\202\320\270", nullptr));
+        pushButton_export->setText(QCoreApplication::translate("Form_orders", "\320\222\321\213\320\263\321\200\321\203\320\267\320\270\321\202\321\214 \320\262 PDF", nullptr));
+    } // retranslateUi
+
+};
+
+namespace Ui {
+    class Form_orders: public Ui_Form_orders {};
+} // namespace Ui
+
+QT_END_NAMESPACE
+
+#endif // UI_FORMORDERS_H
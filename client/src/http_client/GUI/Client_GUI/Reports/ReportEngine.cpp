@@ -0,0 +1,272 @@
+#include "ReportEngine.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFontMetricsF>
+#include <QFutureWatcher>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QPointer>
+#include <QtConcurrent/QtConcurrent>
+
+namespace {
+
+const int ReportResolution = 300;
+
+struct ReportColumn
+{
+    QString title;
+    qreal width; // доля ширины страницы
+    Qt::Alignment alignment;
+};
+
+struct ReportTemplate
+{
+    QFont titleFont;
+    QFont bodyFont;
+    QFont boldFont;
+    QFont footerFont;
+    QVector<ReportColumn> columns;
+};
+
+const int NameColumn = 0;
+
+const ReportTemplate &orderTemplate()
+{
+    // Инициализация статической переменной потокобезопасна, дальше шаблон только читается
+    static const ReportTemplate layout = [] {
+        ReportTemplate result;
+        result.titleFont.setPointSize(16);
+        result.titleFont.setBold(true);
+        result.bodyFont.setPointSize(10);
+        result.boldFont = result.bodyFont;
+        result.boldFont.setBold(true);
+        result.footerFont.setPointSize(8);
+
+        const Qt::Alignment right = Qt::AlignRight | Qt::AlignVCenter;
+        result.columns = {
+                {"Товар", 0.46, Qt::AlignLeft | Qt::AlignVCenter},
+                {"Кол-во", 0.10, right},
+                {"Цена, ₽", 0.15, right},
+                {"Скидка", 0.11, right},
+                {"Сумма, ₽", 0.18, right}
+        };
+        return result;
+    }();
+    return layout;
+}
+
+QString formatDate(const QString &isoDate)
+{
+    const QDateTime date = QDateTime::fromString(isoDate, Qt::ISODateWithMs);
+    return date.isValid() ? date.toString("dd.MM.yyyy hh:mm") : isoDate;
+}
+
+QString money(double value)
+{
+    return QString::number(value, 'f', 2);
+}
+
+// Раскладка заказов по страницам одного документа. Живёт в рабочем потоке одного задания
+class OrderReportPainter
+{
+public:
+    OrderReportPainter(QPdfWriter &writer, QPainter &painter, const ReportTemplate &layout)
+            : writer(writer), painter(painter), layout(layout),
+              bodyMetrics(layout.bodyFont, &writer),
+              titleHeight(QFontMetricsF(layout.titleFont, &writer).height()),
+              lineHeight(bodyMetrics.height() * 1.4),
+              footerHeight(QFontMetricsF(layout.footerFont, &writer).height() * 2),
+              pageWidth(writer.width()),
+              contentBottom(writer.height() - footerHeight)
+    {
+    }
+
+    void drawOrder(const Dto::Transaction &order, bool fromNewPage)
+    {
+        if (fromNewPage) {
+            newPage();
+        }
+
+        painter.setFont(layout.titleFont);
+        painter.drawText(QRectF(0, y, pageWidth, titleHeight), Qt::AlignLeft | Qt::AlignVCenter,
+                         QString("Заказ #%1").arg(order.id));
+        y += titleHeight * 1.3;
+
+        painter.setFont(layout.bodyFont);
+        drawLine(QString("Дата: %1").arg(formatDate(order.transactionDate)));
+        drawLine(QString("Тип: %1").arg(order.isWholesale ? "Оптовый" : "Розничный"));
+        y += lineHeight / 2;
+
+        drawTableHeader();
+        for (const Dto::TransactionDetail &detail : order.details) {
+            if (y + lineHeight > contentBottom) {
+                newPage();
+                drawTableHeader();
+            }
+            drawRow({detail.productName,
+                     QString::number(detail.quantity),
+                     money(detail.currentPrice),
+                     QString("%1%").arg(detail.discount * 100, 0, 'f', 1),
+                     money(detail.calculatedTotal)},
+                    layout.bodyFont);
+        }
+
+        // Итоги не отрываются друг от друга
+        if (y + lineHeight * 4 > contentBottom) {
+            newPage();
+        }
+        y += lineHeight / 2;
+        painter.setFont(layout.bodyFont);
+        drawLine(QString("Сумма без скидки: %1 ₽").arg(money(order.totalAmount + order.discountAmount)));
+        drawLine(QString("Скидка: %1 ₽").arg(money(order.discountAmount)));
+        painter.setFont(layout.boldFont);
+        drawLine(QString("Итого к оплате: %1 ₽").arg(money(order.totalAmount)));
+    }
+
+    void finish()
+    {
+        drawPageNumber();
+    }
+
+private:
+    void newPage()
+    {
+        drawPageNumber();
+        writer.newPage();
+        ++pageNumber;
+        y = 0;
+    }
+
+    void drawPageNumber()
+    {
+        painter.setFont(layout.footerFont);
+        painter.drawText(QRectF(0, contentBottom, pageWidth, footerHeight), Qt::AlignRight | Qt::AlignBottom,
+                         QString("Стр. %1").arg(pageNumber));
+    }
+
+    void drawLine(const QString &text)
+    {
+        painter.drawText(QRectF(0, y, pageWidth, lineHeight), Qt::AlignLeft | Qt::AlignVCenter, text);
+        y += lineHeight;
+    }
+
+    void drawTableHeader()
+    {
+        QStringList titles;
+        for (const ReportColumn &column : layout.columns) {
+            titles.append(column.title);
+        }
+        drawRow(titles, layout.boldFont);
+        painter.drawLine(QPointF(0, y), QPointF(pageWidth, y));
+    }
+
+    void drawRow(const QStringList &cells, const QFont &font)
+    {
+        painter.setFont(font);
+        const qreal padding = lineHeight / 4;
+
+        qreal x = 0;
+        for (int i = 0; i < layout.columns.size() && i < cells.size(); ++i) {
+            const ReportColumn &column = layout.columns.at(i);
+            const qreal width = column.width * pageWidth;
+            const QRectF cell(x + padding, y, width - 2 * padding, lineHeight);
+            // Длинные названия товаров обрезаются, чтобы строка отчёта оставалась одной строкой таблицы
+            const QString text = i == NameColumn ? bodyMetrics.elidedText(cells.at(i), Qt::ElideRight, cell.width())
+                                                 : cells.at(i);
+            painter.drawText(cell, int(column.alignment), text);
+            x += width;
+        }
+        y += lineHeight;
+    }
+
+    QPdfWriter &writer;
+    QPainter &painter;
+    const ReportTemplate &layout;
+    const QFontMetricsF bodyMetrics;
+    const qreal titleHeight;
+    const qreal lineHeight;
+    const qreal footerHeight;
+    const qreal pageWidth;
+    const qreal contentBottom;
+    qreal y = 0;
+    int pageNumber = 1;
+};
+
+bool renderOrders(const QVector<Dto::Transaction> &orders, const QString &fileName,
+                  const std::function<void(int, int)> &progress)
+{
+    QPdfWriter writer(fileName);
+    writer.setPageSize(QPageSize(QPageSize::A4));
+    writer.setPageMargins(QMarginsF(15, 15, 15, 15), QPageLayout::Millimeter);
+    writer.setResolution(ReportResolution);
+    writer.setCreator(QCoreApplication::applicationName());
+    writer.setTitle(orders.size() == 1 ? QString("Заказ #%1").arg(orders.first().id) : QString("Выписка по заказам"));
+
+    QPainter painter;
+    if (!painter.begin(&writer)) {
+        return false;
+    }
+
+    OrderReportPainter report(writer, painter, orderTemplate());
+    for (int i = 0; i < orders.size(); ++i) {
+        report.drawOrder(orders.at(i), i > 0);
+        progress(i + 1, orders.size());
+    }
+    report.finish();
+    return painter.end();
+}
+
+}
+
+ReportEngine::ReportEngine(QObject *parent) : QObject(parent)
+{
+    // Один поток: задания пишут файлы по очереди и не соперничают с декодированием миниатюр
+    pool.setMaxThreadCount(1);
+}
+
+ReportEngine::~ReportEngine()
+{
+    pool.waitForDone();
+}
+
+ReportEngine &ReportEngine::shared()
+{
+    static QPointer<ReportEngine> instance;
+    if (!instance) {
+        instance = new ReportEngine(QCoreApplication::instance());
+    }
+    return *instance;
+}
+
+void ReportEngine::exportOrders(const QVector<Dto::Transaction> &orders, const QString &fileName, QObject *context,
+                                FinishedCallback finished, ProgressCallback progress)
+{
+    const QPointer<QObject> receiver(context);
+    const bool hasContext = context != nullptr;
+    auto *watcher = new QFutureWatcher<bool>(this);
+
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [watcher, receiver, hasContext, finished]() {
+        watcher->deleteLater();
+        if ((hasContext && !receiver) || !finished) {
+            return;
+        }
+        finished(watcher->result());
+    });
+
+    // Прогресс из рабочего потока доставляется через очередь событий движка: он живёт, пока живо приложение,
+    // а окно-получатель проверяется уже в GUI-потоке
+    auto report = [this, receiver, hasContext, progress](int done, int total) {
+        if (!progress) {
+            return;
+        }
+        QMetaObject::invokeMethod(this, [receiver, hasContext, progress, done, total]() {
+            if (!hasContext || receiver) {
+                progress(done, total);
+            }
+        }, Qt::QueuedConnection);
+    };
+
+    watcher->setFuture(QtConcurrent::run(&pool, [orders, fileName, report]() {
+        return renderOrders(orders, fileName, report);
+    }));
+}
@@ -0,0 +1,35 @@
+#ifndef HTTP_CLIENT_REPORTENGINE_H
+#define HTTP_CLIENT_REPORTENGINE_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <functional>
+#include "http_client/http_requests/Dto.h"
+
+// Отчёты по заказам в PDF. Страницы рисуются (QPdfWriter + QPainter) в отдельном потоке,
+// поэтому выписка на сотни заказов не останавливает интерфейс. Задания выполняются по очереди,
+// шрифты и разметка колонок создаются один раз и общие для всех отчётов
+class ReportEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    using FinishedCallback = std::function<void(bool ok)>;
+    using ProgressCallback = std::function<void(int done, int total)>;
+
+    static ReportEngine &shared();
+    ~ReportEngine();
+
+    // Заказы в одном файле, каждый с новой страницы; строки, не поместившиеся на страницу,
+    // продолжаются на следующей под повторённой шапкой таблицы.
+    // Колбэки вызываются в GUI-потоке; если context задан и уже удалён - не вызываются
+    void exportOrders(const QVector<Dto::Transaction> &orders, const QString &fileName, QObject *context,
+                      FinishedCallback finished, ProgressCallback progress = nullptr);
+
+private:
+    explicit ReportEngine(QObject *parent = nullptr);
+
+    QThreadPool pool;
+};
+
+#endif //HTTP_CLIENT_REPORTENGINE_H
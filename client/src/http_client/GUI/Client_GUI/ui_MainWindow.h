@@ -16,7 +16,7 @@
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QMainWindow>
 #include <QtWidgets/QPushButton>
-#include <QtWidgets/QTableWidget>
+#include <QtWidgets/QTableView>
 #include <QtWidgets/QTextEdit>
 #include <QtWidgets/QWidget>
 
@@ -36,7 +36,7 @@ public:
     QLabel *label;
     QPushButton *pushButton_orders;
     QPushButton *pushButton_reset_filters;
-    QTableWidget *tableWidget;
+    QTableView *tableView;
     QPushButton *pushButton_sort_products;
     QPushButton *pushButton_add_to_cart;
 
@@ -108,23 +108,9 @@ public:
         pushButton_reset_filters->setFont(font1);
         pushButton_reset_filters->setStyleSheet(QString::fromUtf8("QPushButton{background-color: rgb(248, 30, 20)}\n"
 "QPushButton{border: 2px solid black}"));
-        tableWidget = new QTableWidget(centralwidget);
-        if (tableWidget->columnCount() < 6)
-            tableWidget->setColumnCount(6);
-        QTableWidgetItem *__qtablewidgetitem = new QTableWidgetItem();
-        tableWidget->setHorizontalHeaderItem(0, __qtablewidgetitem);
-        QTableWidgetItem *__qtablewidgetitem1 = new QTableWidgetItem();
-        tableWidget->setHorizontalHeaderItem(1, __qtablewidgetitem1);
-        QTableWidgetItem *__qtablewidgetitem2 = new QTableWidgetItem();
-        tableWidget->setHorizontalHeaderItem(2, __qtablewidgetitem2);
-        QTableWidgetItem *__qtablewidgetitem3 = new QTableWidgetItem();
-        tableWidget->setHorizontalHeaderItem(3, __qtablewidgetitem3);
-        QTableWidgetItem *__qtablewidgetitem4 = new QTableWidgetItem();
-        tableWidget->setHorizontalHeaderItem(4, __qtablewidgetitem4);
-        QTableWidgetItem *__qtablewidgetitem5 = new QTableWidgetItem();
-        tableWidget->setHorizontalHeaderItem(5, __qtablewidgetitem5);
-        tableWidget->setObjectName(QString::fromUtf8("tableWidget"));
-        tableWidget->setGeometry(QRect(20, 330, 1051, 291));
+        tableView = new QTableView(centralwidget);
+        tableView->setObjectName(QString::fromUtf8("tableView"));
+        tableView->setGeometry(QRect(20, 330, 1051, 291));
         pushButton_sort_products = new QPushButton(centralwidget);
         pushButton_sort_products->setObjectName(QString::fromUtf8("pushButton_sort_products"));
         pushButton_sort_products->setGeometry(QRect(260, 150, 131, 31));
@@ -155,18 +141,6 @@ public:
         label->setText(QCoreApplication::translate("MainWindowCustomer", "\320\222\321\213\320\261\320\265\321\200\320\270\321\202\320\265 \320\272\321\200\320\270\321\202\320\265\321\200\320\270\320\271 \321\201\320\276\321\200\321\202\320\270\321\200\320\276\320\262\320\272\320\270:", nullptr));
         pushButton_orders->setText(QCoreApplication::translate("MainWindowCustomer", "\320\227\320\260\320\272\320\260\320\267\321\213", nullptr));
         pushButton_reset_filters->setText(QCoreApplication::translate("MainWindowCustomer", "\320\241\320\261\321\200\320\276\321\201\320\270\321\202\321\214 ", nullptr));
-        QTableWidgetItem *___qtablewidgetitem = tableWidget->horizontalHeaderItem(0);
-        ___qtablewidgetitem->setText(QCoreApplication::translate("MainWindowCustomer", "id", nullptr));
-        QTableWidgetItem *___qtablewidgetitem1 = tableWidget->horizontalHeaderItem(1);
-        ___qtablewidgetitem1->setText(QCoreApplication::translate("MainWindowCustomer", "photo", nullptr));
-        QTableWidgetItem *___qtablewidgetitem2 = tableWidget->horizontalHeaderItem(2);
-        ___qtablewidgetitem2->setText(QCoreApplication::translate("MainWindowCustomer", "name", nullptr));
-        QTableWidgetItem *___qtablewidgetitem3 = tableWidget->horizontalHeaderItem(3);
-        ___qtablewidgetitem3->setText(QCoreApplication::translate("MainWindowCustomer", "optprice", nullptr));
-        QTableWidgetItem *___qtablewidgetitem4 = tableWidget->horizontalHeaderItem(4);
-        ___qtablewidgetitem4->setText(QCoreApplication::translate("MainWindowCustomer", "roznprice", nullptr));
-        QTableWidgetItem *___qtablewidgetitem5 = tableWidget->horizontalHeaderItem(5);
-        ___qtablewidgetitem5->setText(QCoreApplication::translate("MainWindowCustomer", "description", nullptr));
         pushButton_sort_products->setText(QCoreApplication::translate("MainWindowCustomer", "\320\241\320\276\321\200\321\202\320\270\321\200\320\276\320\262\320\260\321\202\321\214", nullptr));
         pushButton_add_to_cart->setText(QCoreApplication::translate("MainWindowCustomer", "\320\224\320\276\320\261\320\260\320\262\320\270\321\202\321\214 \320\262 \320\272\320\276\321\200\320\267\320\270\320\275\321\203", nullptr));
     } // retranslateUi
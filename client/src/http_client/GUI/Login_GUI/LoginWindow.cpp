@@ -29,27 +29,31 @@ void LoginWindow::on_pushButton_login_clicked()
     credentials["email"] = email;
     credentials["password"] = QString(hashedPassword);
 
-    QJsonObject response = requests->login(credentials);
-    qDebug() << "Login response:" << response;
-
-    if(response.contains("CustomerID"))
-    {
-        UserSession::instance().setCustomerData(
-                response["CustomerID"].toInt(),
-                response["Name"].toString(),
-                response["Email"].toString(),
-                response["Phone"].toString(),
-                response["Address"].toString(),
-                response["ContactPerson"].toString()
-        );
-
-        this->done(QDialog::Accepted);
-    }
-    else
-    {
-        QString error = response.value("detail").toString("Ошибка авторизации");
-        QMessageBox::warning(this, "Ошибка", error);
-    }
+    ui->pushButton_login->setEnabled(false);
+
+    requests->loginAsync(credentials, this, [this](const QJsonObject &response) {
+        ui->pushButton_login->setEnabled(true);
+        qDebug() << "Login response:" << response;
+
+        if(response.contains("CustomerID"))
+        {
+            UserSession::instance().setCustomerData(
+                    response["CustomerID"].toInt(),
+                    response["Name"].toString(),
+                    response["Email"].toString(),
+                    response["Phone"].toString(),
+                    response["Address"].toString(),
+                    response["ContactPerson"].toString()
+            );
+
+            this->done(QDialog::Accepted);
+        }
+        else
+        {
+            QString error = response.value("detail").toString("Ошибка авторизации");
+            QMessageBox::warning(this, "Ошибка", error);
+        }
+    });
 }
 
 void LoginWindow::on_pushButton_register_clicked()
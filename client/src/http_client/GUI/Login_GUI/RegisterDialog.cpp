@@ -4,7 +4,7 @@
 #include <QCryptographicHash>
 #include <QMessageBox>
 
-RegisterDialog::RegisterDialog(QWidget *parent) : QDialog(parent), ui(new Ui::RegisterDialog)
+RegisterDialog::RegisterDialog(QWidget *parent) : QDialog(parent), ui(new Ui::RegisterDialog), requests(new Requests(this))
 {
     ui->setupUi(this);
     setWindowTitle("Регистрация нового пользователя");
@@ -43,20 +43,23 @@ void RegisterDialog::handleRegistration()
     customerData["contact_person"] = contactPerson;
     customerData["password"] = QString(hashedPassword);
 
-    Requests requests(this);
-    QJsonObject response = requests.registerCustomer(customerData);
+    ui->pushButton->setEnabled(false);
 
-    if(response.contains("CustomerID"))
-    {
-        QMessageBox::information(this, "Успех", "Регистрация прошла успешно!");
-        emit registrationComplete(response);
-        this->close();
-    }
-    else
-    {
-        QString error = response.value("detail").toString("Ошибка регистрации");
-        QMessageBox::warning(this, "Ошибка", error);
-    }
+    requests->registerCustomerAsync(customerData, this, [this](const QJsonObject &response) {
+        ui->pushButton->setEnabled(true);
+
+        if(response.contains("CustomerID"))
+        {
+            QMessageBox::information(this, "Успех", "Регистрация прошла успешно!");
+            emit registrationComplete(response);
+            this->close();
+        }
+        else
+        {
+            QString error = response.value("detail").toString("Ошибка регистрации");
+            QMessageBox::warning(this, "Ошибка", error);
+        }
+    });
 }
 
 RegisterDialog::~RegisterDialog()
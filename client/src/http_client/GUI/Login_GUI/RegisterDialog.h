@@ -2,11 +2,14 @@
 #define REGISTERDIALOG_H
 
 #include <QDialog>
+#include <QJsonObject>
 
 namespace Ui {
 class RegisterDialog;
 }
 
+class Requests;
+
 class RegisterDialog : public QDialog
 {
     Q_OBJECT
@@ -23,6 +26,7 @@ private slots:
 
 private:
     Ui::RegisterDialog *ui;
+    Requests *requests;
 };
 
 #endif // REGISTERDIALOG_H
@@ -0,0 +1,103 @@
+#include "CartOperationQueue.h"
+#include <QTimer>
+#include "Requests.h"
+
+CartOperationQueue::CartOperationQueue(Requests *requests, int customerId, QObject *parent)
+        : QObject(parent), requests(requests), customerId(customerId), flushTimer(new QTimer(this))
+{
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(FlushDelayMs);
+    connect(flushTimer, &QTimer::timeout, this, &CartOperationQueue::send);
+}
+
+void CartOperationQueue::add(int productId, int quantity)
+{
+    if (quantity == 0)
+    {
+        return;
+    }
+
+    int &delta = queued[productId];
+    delta += quantity;
+    if (delta == 0)
+    {
+        queued.remove(productId);
+    }
+    emit pendingChanged();
+
+    // Большой пакет отправляется сразу; иначе ждём паузу, чтобы собрать серию нажатий.
+    // Таймер не перезапускается: непрерывные нажатия не откладывают отправку бесконечно
+    if (queued.size() >= MaxBatchSize)
+    {
+        flush();
+    }
+    else if (!flushTimer->isActive())
+    {
+        flushTimer->start();
+    }
+}
+
+void CartOperationQueue::flush()
+{
+    flushTimer->stop();
+    send();
+}
+
+void CartOperationQueue::clear()
+{
+    flushTimer->stop();
+    if (!queued.isEmpty())
+    {
+        queued.clear();
+        emit pendingChanged();
+    }
+}
+
+QHash<int, int> CartOperationQueue::pending() const
+{
+    QHash<int, int> result = inFlight;
+    for (auto it = queued.constBegin(); it != queued.constEnd(); ++it)
+    {
+        result[it.key()] += it.value();
+    }
+    return result;
+}
+
+void CartOperationQueue::send()
+{
+    if (!inFlight.isEmpty() || queued.isEmpty())
+    {
+        return;
+    }
+
+    inFlight.swap(queued);
+
+    QVector<Dto::CartOperation> operations;
+    operations.reserve(inFlight.size());
+    for (auto it = inFlight.constBegin(); it != inFlight.constEnd(); ++it)
+    {
+        operations.append({it.key(), it.value()});
+    }
+
+    requests->applyCartOperationsAsync(customerId, operations, this, [this](bool ok, const Dto::Cart &cart) {
+        // Пакет уже не считается ожидающим, когда подписчики получают ответ:
+        // подтверждённая корзина и pending() не должны учитывать его дважды
+        const int count = inFlight.size();
+        inFlight.clear();
+
+        if (ok)
+        {
+            emit flushed(cart);
+        }
+        else
+        {
+            emit failed(count);
+        }
+        emit pendingChanged();
+
+        if (!queued.isEmpty() && !flushTimer->isActive())
+        {
+            flushTimer->start();
+        }
+    });
+}
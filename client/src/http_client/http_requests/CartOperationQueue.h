@@ -0,0 +1,53 @@
+#ifndef HTTP_CLIENT_CARTOPERATIONQUEUE_H
+#define HTTP_CLIENT_CARTOPERATIONQUEUE_H
+
+#include <QObject>
+#include <QHash>
+#include "Dto.h"
+
+class Requests;
+class QTimer;
+
+// Очередь изменений корзины. Добавления и удаления копятся и уходят на сервер одним пакетом
+// (POST /customers/{id}/cart/batch): серия нажатий даёт один запрос и одну транзакцию.
+// Изменения одного товара складываются. Пока пакет в пути, новые изменения ждут следующего.
+class CartOperationQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    CartOperationQueue(Requests *requests, int customerId, QObject *parent = nullptr);
+
+    // quantity < 0 - убрать товар из корзины
+    void add(int productId, int quantity);
+    // Отправить накопленное, не дожидаясь паузы; ответ придёт сигналом flushed или failed
+    void flush();
+    // Отбросить неотправленные изменения (корзина очищается). Пакет, который уже в пути, не отменяется
+    void clear();
+
+    // Изменения, ещё не подтверждённые сервером: в очереди и в отправленном пакете
+    QHash<int, int> pending() const;
+    bool isIdle() const { return queued.isEmpty() && inFlight.isEmpty(); }
+    bool isSending() const { return !inFlight.isEmpty(); }
+
+signals:
+    void pendingChanged();
+    // Сервер принял пакет; cart - корзина после него
+    void flushed(const Dto::Cart &cart);
+    // Пакет не принят, его изменения отброшены
+    void failed(int productCount);
+
+private:
+    void send();
+
+    Requests *requests;
+    int customerId;
+    QHash<int, int> queued; // номер товара -> изменение количества
+    QHash<int, int> inFlight;
+    QTimer *flushTimer;
+
+    static const int FlushDelayMs = 300;
+    static const int MaxBatchSize = 100;
+};
+
+#endif //HTTP_CLIENT_CARTOPERATIONQUEUE_H
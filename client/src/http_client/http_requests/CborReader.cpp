@@ -0,0 +1,161 @@
+#include "CborReader.h"
+
+CborReader::CborReader(const QByteArray &data) : reader(data)
+{
+    keyBuffer.reserve(64);
+}
+
+void CborReader::fail()
+{
+    failed = true;
+}
+
+bool CborReader::hasError() const
+{
+    return failed || reader.lastError() != QCborError::NoError;
+}
+
+bool CborReader::enter(bool isContainer)
+{
+    if (hasError()) {
+        return false;
+    }
+    if (!isContainer) {
+        skip();
+        return false;
+    }
+    return reader.enterContainer();
+}
+
+bool CborReader::beginObject()
+{
+    return enter(reader.isMap());
+}
+
+bool CborReader::beginArray()
+{
+    return enter(reader.isArray());
+}
+
+bool CborReader::hasNextInContainer()
+{
+    if (hasError()) {
+        return false;
+    }
+    if (!reader.hasNext()) {
+        reader.leaveContainer();
+        return false;
+    }
+    return true;
+}
+
+bool CborReader::nextField(QLatin1String &key)
+{
+    if (!hasNextInContainer()) {
+        return false;
+    }
+
+    if (!reader.isString()) {
+        fail();
+        return false;
+    }
+
+    // Ключ читается кусками прямо в переиспользуемый буфер, без создания QString
+    keyBuffer.resize(0);
+    QCborStreamReader::StringResult<qsizetype> chunk;
+    do {
+        const qsizetype offset = keyBuffer.size();
+        const qsizetype size = reader.currentStringChunkSize();
+        keyBuffer.resize(int(offset + qMax<qsizetype>(size, 0)));
+        chunk = reader.readStringChunk(keyBuffer.data() + offset, size);
+        if (chunk.status == QCborStreamReader::Ok) {
+            keyBuffer.resize(int(offset + chunk.data));
+        }
+    } while (chunk.status == QCborStreamReader::Ok);
+
+    if (chunk.status == QCborStreamReader::Error) {
+        fail();
+        return false;
+    }
+
+    key = QLatin1String(keyBuffer.constData(), keyBuffer.size());
+    return true;
+}
+
+bool CborReader::nextElement()
+{
+    return hasNextInContainer();
+}
+
+qint64 CborReader::readInteger()
+{
+    qint64 value = 0;
+    if (reader.isInteger()) {
+        value = reader.toInteger();
+    } else if (reader.isDouble()) {
+        value = qint64(reader.toDouble());
+    } else if (!reader.isNull()) {
+        fail();
+    }
+    reader.next();
+    return value;
+}
+
+double CborReader::readDouble()
+{
+    double value = 0;
+    if (reader.isDouble()) {
+        value = reader.toDouble();
+    } else if (reader.isFloat()) {
+        value = reader.toFloat();
+    } else if (reader.isFloat16()) {
+        value = float(reader.toFloat16());
+    } else if (reader.isInteger()) {
+        value = double(reader.toInteger());
+    } else if (!reader.isNull()) {
+        fail();
+    }
+    reader.next();
+    return value;
+}
+
+bool CborReader::readBool()
+{
+    bool value = false;
+    if (reader.isBool()) {
+        value = reader.toBool();
+    } else if (!reader.isNull()) {
+        fail();
+    }
+    reader.next();
+    return value;
+}
+
+QString CborReader::readString()
+{
+    if (!reader.isString()) {
+        if (!reader.isNull()) {
+            fail();
+        }
+        reader.next();
+        return QString();
+    }
+
+    QString value;
+    QCborStreamReader::StringResult<QString> chunk = reader.readString();
+    while (chunk.status == QCborStreamReader::Ok) {
+        value += chunk.data;
+        chunk = reader.readString();
+    }
+    if (chunk.status == QCborStreamReader::Error) {
+        fail();
+    }
+    return value;
+}
+
+void CborReader::skip()
+{
+    if (!hasError()) {
+        reader.next();
+    }
+}
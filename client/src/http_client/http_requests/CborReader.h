@@ -0,0 +1,40 @@
+#ifndef HTTP_CLIENT_CBORREADER_H
+#define HTTP_CLIENT_CBORREADER_H
+
+#include <QByteArray>
+#include <QCborStreamReader>
+#include <QLatin1String>
+#include <QString>
+
+// Потоковый разбор CBOR-ответа с тем же интерфейсом, что у JsonReader,
+// поэтому парсеры из DtoParsers.h работают с обоими форматами без изменений.
+// Числа приходят в двоичном виде и не разбираются из текста.
+class CborReader
+{
+public:
+    explicit CborReader(const QByteArray &data);
+
+    bool beginObject();
+    bool beginArray();
+    bool nextField(QLatin1String &key);
+    bool nextElement();
+
+    qint64 readInteger();
+    double readDouble();
+    bool readBool();
+    QString readString();
+    void skip();
+
+    bool hasError() const;
+
+private:
+    bool enter(bool isContainer);
+    bool hasNextInContainer();
+    void fail();
+
+    QCborStreamReader reader;
+    QByteArray keyBuffer; // ёмкость переиспользуется для всех ключей документа
+    bool failed = false;
+};
+
+#endif //HTTP_CLIENT_CBORREADER_H
@@ -0,0 +1,128 @@
+#ifndef HTTP_CLIENT_DTO_H
+#define HTTP_CLIENT_DTO_H
+
+#include <QString>
+#include <QVector>
+
+// Типизированные ответы сервера. Заполняются потоковыми парсерами из DtoParsers.h
+// прямо из тела ответа, без промежуточного QJsonDocument.
+namespace Dto
+{
+    struct Product
+    {
+        int id = 0;
+        QString name;
+        double wholesalePrice = 0;
+        double retailPrice = 0;
+        QString description;
+        QString imageHash;
+    };
+
+    struct ProductsPage
+    {
+        QVector<Product> products;
+        QString nextCursor; // пустой - страница последняя
+    };
+
+    // Изменения каталога после известной клиенту версии (/products/changes)
+    struct CatalogChanges
+    {
+        QString version; // версия, до которой дотягивают эти изменения
+        QVector<Product> products; // новые и изменённые товары
+        QVector<int> deleted; // номера удалённых товаров
+        bool hasMore = false; // изменений больше, чем влезло в ответ: запросить ещё раз с новой версией
+        bool reset = false; // сервер не знает версию клиента, нужен полный каталог
+    };
+
+    struct CartItem
+    {
+        int cartItemId = 0;
+        int productId = 0;
+        QString productName;
+        int quantity = 0;
+        double price = 0;
+    };
+
+    // Ступень скидки: действует, если количество в [minQuantity, maxQuantity] и сумма не меньше minTotalPrice
+    struct Discount
+    {
+        int id = 0;
+        int minQuantity = 0;
+        int maxQuantity = 0;
+        double rate = 0;
+        double minTotalPrice = 0;
+    };
+
+    struct DiscountsList
+    {
+        QVector<Discount> discounts;
+    };
+
+    // Изменение количества товара в корзине; отрицательное убирает товар
+    struct CartOperation
+    {
+        int productId = 0;
+        int quantity = 0;
+    };
+
+    struct Cart
+    {
+        int cartId = 0;
+        int customerId = 0;
+        QVector<CartItem> items;
+        int totalItems = 0;
+        double totalPrice = 0;
+        double discountedPrice = 0;
+        double discountRate = 0;
+    };
+
+    struct TransactionDetail
+    {
+        int id = 0;
+        int productId = 0;
+        QString productName;
+        int quantity = 0;
+        double discount = 0;
+        double currentPrice = 0;
+        double calculatedTotal = 0;
+    };
+
+    struct Transaction
+    {
+        int id = 0;
+        int customerId = 0;
+        int employeeId = 0;
+        bool isWholesale = false;
+        QString transactionDate;
+        double totalAmount = 0;
+        double discountAmount = 0;
+        QVector<TransactionDetail> details;
+    };
+
+    // Вся история покупателя со строками заказов (для выгрузки в отчёт)
+    struct TransactionsList
+    {
+        QVector<Transaction> transactions;
+    };
+
+    // Заголовок заказа в истории; строки заказа запрашиваются отдельно
+    struct OrderSummary
+    {
+        int id = 0;
+        int employeeId = 0;
+        bool isWholesale = false;
+        QString transactionDate;
+        int itemCount = 0;
+        int totalQuantity = 0;
+        double totalAmount = 0; // с учётом скидки
+        double discountAmount = 0;
+    };
+
+    struct OrdersPage
+    {
+        QVector<OrderSummary> orders;
+        QString nextCursor; // пустой - заказы старше этих закончились
+    };
+}
+
+#endif //HTTP_CLIENT_DTO_H
@@ -0,0 +1,265 @@
+#ifndef HTTP_CLIENT_DTOPARSERS_H
+#define HTTP_CLIENT_DTOPARSERS_H
+
+#include <QByteArray>
+#include <QLatin1String>
+#include "Dto.h"
+
+// Разбор ответов сервера в Dto. Парсеры шаблонные по типу Reader: CborReader для ответов в CBOR,
+// JsonReader для JSON (сервер без CBOR и события корзины). Читателю
+// нужен только интерфейс beginObject/nextField/beginArray/nextElement/read*/skip.
+// Ключи сравниваются с литералами прямо в буфере ответа, строки под них не создаются.
+namespace Dto
+{
+    template <typename Reader>
+    void readField(Reader &reader, int &value) { value = int(reader.readInteger()); }
+
+    template <typename Reader>
+    void readField(Reader &reader, double &value) { value = reader.readDouble(); }
+
+    template <typename Reader>
+    void readField(Reader &reader, bool &value) { value = reader.readBool(); }
+
+    template <typename Reader>
+    void readField(Reader &reader, QString &value) { value = reader.readString(); }
+
+    // Элемент массива чисел
+    template <typename Reader>
+    void read(Reader &reader, int &value) { readField(reader, value); }
+
+    template <typename Reader, typename T>
+    void readField(Reader &reader, QVector<T> &values)
+    {
+        if (!reader.beginArray()) {
+            return;
+        }
+        while (reader.nextElement()) {
+            values.append(T());
+            read(reader, values.last());
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, Product &product)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("ProductID")) readField(reader, product.id);
+            else if (key == QLatin1String("Name")) readField(reader, product.name);
+            else if (key == QLatin1String("WholesalePrice")) readField(reader, product.wholesalePrice);
+            else if (key == QLatin1String("RetailPrice")) readField(reader, product.retailPrice);
+            else if (key == QLatin1String("Description")) readField(reader, product.description);
+            else if (key == QLatin1String("ImageHash")) readField(reader, product.imageHash);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, ProductsPage &page)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("products")) readField(reader, page.products);
+            else if (key == QLatin1String("next_cursor")) readField(reader, page.nextCursor);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, CatalogChanges &changes)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("version")) readField(reader, changes.version);
+            else if (key == QLatin1String("products")) readField(reader, changes.products);
+            else if (key == QLatin1String("deleted")) readField(reader, changes.deleted);
+            else if (key == QLatin1String("has_more")) readField(reader, changes.hasMore);
+            else if (key == QLatin1String("reset")) readField(reader, changes.reset);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, Discount &discount)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("DiscountID")) readField(reader, discount.id);
+            else if (key == QLatin1String("MinQuantity")) readField(reader, discount.minQuantity);
+            else if (key == QLatin1String("MaxQuantity")) readField(reader, discount.maxQuantity);
+            else if (key == QLatin1String("DiscountRate")) readField(reader, discount.rate);
+            else if (key == QLatin1String("MinTotalPrice")) readField(reader, discount.minTotalPrice);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, DiscountsList &list)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("discounts")) readField(reader, list.discounts);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, CartItem &item)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("CartItemID")) readField(reader, item.cartItemId);
+            else if (key == QLatin1String("ProductID")) readField(reader, item.productId);
+            else if (key == QLatin1String("ProductName")) readField(reader, item.productName);
+            else if (key == QLatin1String("Quantity")) readField(reader, item.quantity);
+            else if (key == QLatin1String("Price")) readField(reader, item.price);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, Cart &cart)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("CartID")) readField(reader, cart.cartId);
+            else if (key == QLatin1String("CustomerID")) readField(reader, cart.customerId);
+            else if (key == QLatin1String("items")) readField(reader, cart.items);
+            else if (key == QLatin1String("total_items")) readField(reader, cart.totalItems);
+            else if (key == QLatin1String("total_price")) readField(reader, cart.totalPrice);
+            else if (key == QLatin1String("discounted_price")) readField(reader, cart.discountedPrice);
+            else if (key == QLatin1String("discount_rate")) readField(reader, cart.discountRate);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, TransactionDetail &detail)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("TransactionDetailID")) readField(reader, detail.id);
+            else if (key == QLatin1String("ProductID")) readField(reader, detail.productId);
+            else if (key == QLatin1String("product_name")) readField(reader, detail.productName);
+            else if (key == QLatin1String("quantity")) readField(reader, detail.quantity);
+            else if (key == QLatin1String("discount")) readField(reader, detail.discount);
+            else if (key == QLatin1String("current_price")) readField(reader, detail.currentPrice);
+            else if (key == QLatin1String("calculated_total")) readField(reader, detail.calculatedTotal);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, Transaction &transaction)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("TransactionID")) readField(reader, transaction.id);
+            else if (key == QLatin1String("CustomerID")) readField(reader, transaction.customerId);
+            else if (key == QLatin1String("EmployeeID")) readField(reader, transaction.employeeId);
+            else if (key == QLatin1String("IsWholesale")) readField(reader, transaction.isWholesale);
+            else if (key == QLatin1String("TransactionDate")) readField(reader, transaction.transactionDate);
+            else if (key == QLatin1String("total_amount")) readField(reader, transaction.totalAmount);
+            else if (key == QLatin1String("discount_amount")) readField(reader, transaction.discountAmount);
+            else if (key == QLatin1String("details")) readField(reader, transaction.details);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, TransactionsList &list)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("transactions")) readField(reader, list.transactions);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, OrderSummary &order)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("TransactionID")) readField(reader, order.id);
+            else if (key == QLatin1String("EmployeeID")) readField(reader, order.employeeId);
+            else if (key == QLatin1String("IsWholesale")) readField(reader, order.isWholesale);
+            else if (key == QLatin1String("TransactionDate")) readField(reader, order.transactionDate);
+            else if (key == QLatin1String("item_count")) readField(reader, order.itemCount);
+            else if (key == QLatin1String("total_quantity")) readField(reader, order.totalQuantity);
+            else if (key == QLatin1String("total_amount")) readField(reader, order.totalAmount);
+            else if (key == QLatin1String("discount_amount")) readField(reader, order.discountAmount);
+            else reader.skip();
+        }
+    }
+
+    template <typename Reader>
+    void read(Reader &reader, OrdersPage &page)
+    {
+        if (!reader.beginObject()) {
+            return;
+        }
+
+        QLatin1String key;
+        while (reader.nextField(key)) {
+            if (key == QLatin1String("orders")) readField(reader, page.orders);
+            else if (key == QLatin1String("next_cursor")) readField(reader, page.nextCursor);
+            else reader.skip();
+        }
+    }
+
+    // Разбор всего тела ответа; false - тело повреждено
+    template <typename Reader, typename T>
+    bool parse(const QByteArray &data, T &out)
+    {
+        Reader reader(data);
+        read(reader, out);
+        return !reader.hasError();
+    }
+}
+
+#endif //HTTP_CLIENT_DTOPARSERS_H
@@ -0,0 +1,172 @@
+#include "EventStream.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTimer>
+#include <QDebug>
+
+EventStream::EventStream(QNetworkAccessManager *manager, const QNetworkRequest &request, QObject *parent)
+        : QObject(parent), manager(manager), request(request), reconnectTimer(new QTimer(this))
+{
+    this->request.setRawHeader("Accept", "text/event-stream");
+    // Поток бесконечный, кэшировать его нельзя
+    this->request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    this->request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+
+    reconnectTimer->setSingleShot(true);
+    connect(reconnectTimer, &QTimer::timeout, this, &EventStream::start);
+}
+
+EventStream::~EventStream()
+{
+    stop();
+}
+
+void EventStream::start()
+{
+    if (reply)
+    {
+        return;
+    }
+
+    stopped = false;
+    buffer.clear();
+    eventType.clear();
+    eventData.clear();
+
+    reply = manager->get(request);
+    connect(reply, &QNetworkReply::readyRead, this, &EventStream::onReadyRead);
+    connect(reply, &QNetworkReply::finished, this, &EventStream::onFinished);
+}
+
+void EventStream::stop()
+{
+    stopped = true;
+    reconnectTimer->stop();
+
+    if (reply)
+    {
+        QNetworkReply *current = reply;
+        reply = nullptr;
+        current->disconnect(this);
+        current->abort();
+        current->deleteLater();
+    }
+
+    if (connectedNow)
+    {
+        connectedNow = false;
+        emit disconnected();
+    }
+}
+
+void EventStream::onReadyRead()
+{
+    if (!connectedNow)
+    {
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status != 200)
+        {
+            return;
+        }
+
+        connectedNow = true;
+        failures = 0;
+        emit connected();
+    }
+
+    buffer += reply->readAll();
+
+    // События разделяются пустой строкой; последняя строка порции может быть неполной
+    int start = 0;
+    int end;
+    while ((end = buffer.indexOf('\n', start)) >= 0)
+    {
+        QByteArray line = buffer.mid(start, end - start);
+        if (line.endsWith('\r'))
+        {
+            line.chop(1);
+        }
+        processLine(line);
+        start = end + 1;
+    }
+    buffer.remove(0, start);
+}
+
+void EventStream::processLine(const QByteArray &line)
+{
+    if (line.isEmpty())
+    {
+        if (!eventData.isEmpty())
+        {
+            eventData.chop(1); // перевод строки после последней строки data
+            emit eventReceived(eventType.isEmpty() ? QStringLiteral("message") : QString::fromUtf8(eventType), eventData);
+        }
+        eventType.clear();
+        eventData.clear();
+        return;
+    }
+
+    if (line.startsWith(':'))
+    {
+        return; // комментарий, сервер так держит соединение живым
+    }
+
+    const int colon = line.indexOf(':');
+    const QByteArray field = colon < 0 ? line : line.left(colon);
+    QByteArray value = colon < 0 ? QByteArray() : line.mid(colon + 1);
+    if (value.startsWith(' '))
+    {
+        value.remove(0, 1);
+    }
+
+    if (field == "event")
+    {
+        eventType = value;
+    }
+    else if (field == "data")
+    {
+        eventData += value;
+        eventData += '\n';
+    }
+    else if (field == "retry")
+    {
+        bool ok = false;
+        const int ms = value.toInt(&ok);
+        if (ok && ms > 0)
+        {
+            retryMs = ms;
+        }
+    }
+}
+
+void EventStream::onFinished()
+{
+    if (reply)
+    {
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            qDebug() << "Event stream error:" << reply->errorString();
+        }
+        reply->deleteLater();
+        reply = nullptr;
+    }
+
+    if (connectedNow)
+    {
+        connectedNow = false;
+        emit disconnected();
+    }
+
+    if (!stopped)
+    {
+        scheduleReconnect();
+    }
+}
+
+void EventStream::scheduleReconnect()
+{
+    // Пауза удваивается с каждой неудачей подряд, чтобы упавший сервер не засыпали переподключениями
+    const int delay = qMin(MaxRetryMs, retryMs << qMin(failures, 5));
+    ++failures;
+    reconnectTimer->start(delay);
+}
@@ -0,0 +1,58 @@
+#ifndef HTTP_CLIENT_EVENTSTREAM_H
+#define HTTP_CLIENT_EVENTSTREAM_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QNetworkRequest>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+// Поток событий сервера (Server-Sent Events). Соединение держится открытым, события
+// разбираются по мере прихода данных. При обрыве поток переподключается сам, с растущей паузой;
+// после переподключения подписчик должен перечитать состояние (сигнал connected).
+class EventStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    EventStream(QNetworkAccessManager *manager, const QNetworkRequest &request, QObject *parent = nullptr);
+    ~EventStream() override;
+
+    void start();
+    void stop();
+    bool isConnected() const { return connectedNow; }
+
+signals:
+    void connected();
+    void disconnected();
+    // type - поле event, data - склеенные строки data (обычно JSON)
+    void eventReceived(const QString &type, const QByteArray &data);
+
+private slots:
+    void onReadyRead();
+    void onFinished();
+
+private:
+    void processLine(const QByteArray &line);
+    void scheduleReconnect();
+
+    QNetworkAccessManager *manager;
+    QNetworkRequest request;
+    QNetworkReply *reply = nullptr;
+    QTimer *reconnectTimer;
+
+    QByteArray buffer; // незавершённая строка из предыдущей порции данных
+    QByteArray eventType;
+    QByteArray eventData;
+    bool connectedNow = false;
+    bool stopped = true;
+    int retryMs = DefaultRetryMs; // сервер может поменять через поле retry
+    int failures = 0;
+
+    static const int DefaultRetryMs = 3000;
+    static const int MaxRetryMs = 60 * 1000;
+};
+
+#endif //HTTP_CLIENT_EVENTSTREAM_H
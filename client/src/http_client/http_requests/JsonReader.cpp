@@ -0,0 +1,344 @@
+#include "JsonReader.h"
+#include <cstring>
+
+namespace
+{
+    int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    void appendUtf8(QByteArray &out, uint code)
+    {
+        if (code < 0x80) {
+            out.append(char(code));
+        } else if (code < 0x800) {
+            out.append(char(0xC0 | (code >> 6)));
+            out.append(char(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.append(char(0xE0 | (code >> 12)));
+            out.append(char(0x80 | ((code >> 6) & 0x3F)));
+            out.append(char(0x80 | (code & 0x3F)));
+        } else {
+            out.append(char(0xF0 | (code >> 18)));
+            out.append(char(0x80 | ((code >> 12) & 0x3F)));
+            out.append(char(0x80 | ((code >> 6) & 0x3F)));
+            out.append(char(0x80 | (code & 0x3F)));
+        }
+    }
+}
+
+JsonReader::JsonReader(const QByteArray &data) : data(data), pos(this->data.constData()), end(pos + this->data.size())
+{
+}
+
+void JsonReader::fail()
+{
+    failed = true;
+    pos = end;
+}
+
+void JsonReader::skipSpace()
+{
+    while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) {
+        ++pos;
+    }
+}
+
+bool JsonReader::consumeLiteral(const char *literal)
+{
+    const size_t length = std::strlen(literal);
+    if (size_t(end - pos) >= length && std::memcmp(pos, literal, length) == 0) {
+        pos += length;
+        return true;
+    }
+    return false;
+}
+
+bool JsonReader::consumeNull()
+{
+    skipSpace();
+    return consumeLiteral("null");
+}
+
+bool JsonReader::beginObject()
+{
+    skipSpace();
+    if (pos < end && *pos == '{') {
+        ++pos;
+        expectFirst = true;
+        return true;
+    }
+    skip();
+    return false;
+}
+
+bool JsonReader::beginArray()
+{
+    skipSpace();
+    if (pos < end && *pos == '[') {
+        ++pos;
+        expectFirst = true;
+        return true;
+    }
+    skip();
+    return false;
+}
+
+bool JsonReader::afterElement(char close)
+{
+    skipSpace();
+    if (pos >= end) {
+        fail();
+        return false;
+    }
+
+    if (*pos == close) {
+        ++pos;
+        expectFirst = false;
+        return false;
+    }
+
+    if (expectFirst) {
+        expectFirst = false;
+        return true;
+    }
+
+    if (*pos != ',') {
+        fail();
+        return false;
+    }
+    ++pos;
+    skipSpace();
+    return true;
+}
+
+bool JsonReader::nextField(QLatin1String &key)
+{
+    if (!afterElement('}')) {
+        return false;
+    }
+
+    if (pos >= end || *pos != '"') {
+        fail();
+        return false;
+    }
+
+    // Ключи сервера - ASCII без экранирования, поэтому их можно сравнивать прямо в буфере
+    const char *start = ++pos;
+    while (pos < end && *pos != '"') {
+        pos += *pos == '\\' ? 2 : 1;
+    }
+    if (pos >= end) {
+        fail();
+        return false;
+    }
+    key = QLatin1String(start, int(pos - start));
+    ++pos;
+
+    skipSpace();
+    if (pos >= end || *pos != ':') {
+        fail();
+        return false;
+    }
+    ++pos;
+    return true;
+}
+
+bool JsonReader::nextElement()
+{
+    return afterElement(']');
+}
+
+QLatin1String JsonReader::numberToken()
+{
+    skipSpace();
+    const char *start = pos;
+    while (pos < end && ((*pos >= '0' && *pos <= '9') || *pos == '-' || *pos == '+' || *pos == '.' || *pos == 'e' || *pos == 'E')) {
+        ++pos;
+    }
+    if (pos == start) {
+        fail();
+    }
+    return QLatin1String(start, int(pos - start));
+}
+
+qint64 JsonReader::readInteger()
+{
+    if (consumeNull()) {
+        return 0;
+    }
+
+    const QLatin1String token = numberToken();
+    // fromRawData не копирует буфер; QByteArray::toLongLong/toDouble не зависят от локали
+    const QByteArray raw = QByteArray::fromRawData(token.data(), token.size());
+    bool ok = false;
+    qint64 value = raw.toLongLong(&ok);
+    if (!ok) {
+        value = qint64(raw.toDouble(&ok));
+    }
+    if (!ok) {
+        fail();
+    }
+    return value;
+}
+
+double JsonReader::readDouble()
+{
+    if (consumeNull()) {
+        return 0;
+    }
+
+    const QLatin1String token = numberToken();
+    bool ok = false;
+    const double value = QByteArray::fromRawData(token.data(), token.size()).toDouble(&ok);
+    if (!ok) {
+        fail();
+    }
+    return value;
+}
+
+bool JsonReader::readBool()
+{
+    skipSpace();
+    if (consumeLiteral("true")) {
+        return true;
+    }
+    if (!consumeLiteral("false") && !consumeLiteral("null")) {
+        fail();
+    }
+    return false;
+}
+
+QString JsonReader::readString()
+{
+    if (consumeNull()) {
+        return QString();
+    }
+    if (pos >= end || *pos != '"') {
+        fail();
+        return QString();
+    }
+
+    const char *start = ++pos;
+    while (pos < end && *pos != '"' && *pos != '\\') {
+        ++pos;
+    }
+    if (pos < end && *pos == '"') {
+        // Строка без экранирования (почти все строки каталога) декодируется прямо из буфера
+        return QString::fromUtf8(start, int(pos++ - start));
+    }
+
+    QByteArray decoded(start, int(pos - start));
+    while (pos < end && *pos != '"') {
+        if (*pos != '\\') {
+            decoded.append(*pos++);
+            continue;
+        }
+
+        if (end - pos < 2) {
+            fail();
+            return QString();
+        }
+        const char escaped = pos[1];
+        pos += 2;
+        switch (escaped) {
+            case '"': decoded.append('"'); break;
+            case '\\': decoded.append('\\'); break;
+            case '/': decoded.append('/'); break;
+            case 'b': decoded.append('\b'); break;
+            case 'f': decoded.append('\f'); break;
+            case 'n': decoded.append('\n'); break;
+            case 'r': decoded.append('\r'); break;
+            case 't': decoded.append('\t'); break;
+            case 'u': {
+                auto readHex = [this](uint &code) {
+                    if (end - pos < 4) {
+                        return false;
+                    }
+                    code = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        const int digit = hexValue(pos[i]);
+                        if (digit < 0) {
+                            return false;
+                        }
+                        code = code * 16 + uint(digit);
+                    }
+                    pos += 4;
+                    return true;
+                };
+
+                uint code = 0;
+                if (!readHex(code)) {
+                    fail();
+                    return QString();
+                }
+                // Символы вне BMP приходят суррогатной парой
+                if (code >= 0xD800 && code <= 0xDBFF && end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u') {
+                    pos += 2;
+                    uint low = 0;
+                    if (!readHex(low)) {
+                        fail();
+                        return QString();
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(decoded, code);
+                break;
+            }
+            default:
+                fail();
+                return QString();
+        }
+    }
+
+    if (pos >= end) {
+        fail();
+        return QString();
+    }
+    ++pos;
+    return QString::fromUtf8(decoded);
+}
+
+void JsonReader::skip()
+{
+    skipSpace();
+    if (pos >= end) {
+        fail();
+        return;
+    }
+
+    if (*pos == '"') {
+        readString();
+        return;
+    }
+
+    if (*pos != '{' && *pos != '[') {
+        if (!consumeLiteral("true") && !consumeLiteral("false") && !consumeLiteral("null")) {
+            numberToken();
+        }
+        return;
+    }
+
+    // Вложенные объекты и массивы пропускаются подсчётом скобок, строки внутри - целиком
+    int depth = 0;
+    while (pos < end) {
+        const char c = *pos;
+        if (c == '"') {
+            readString();
+            continue;
+        }
+        ++pos;
+        if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                return;
+            }
+        }
+    }
+    fail();
+}
@@ -0,0 +1,48 @@
+#ifndef HTTP_CLIENT_JSONREADER_H
+#define HTTP_CLIENT_JSONREADER_H
+
+#include <QByteArray>
+#include <QLatin1String>
+#include <QString>
+
+// Потоковый (pull) разбор JSON прямо из буфера ответа: значения читаются по мере обхода,
+// дерево документа не строится. Ключи отдаются как QLatin1String над исходным буфером, без копирования.
+// При ошибке разбора все последующие чтения возвращают значения по умолчанию, а hasError() - true.
+class JsonReader
+{
+public:
+    explicit JsonReader(const QByteArray &data);
+
+    // Вход в объект/массив; false, если на этом месте другое значение (оно пропускается)
+    bool beginObject();
+    bool beginArray();
+    // Следующее поле объекта; false - объект закончился
+    bool nextField(QLatin1String &key);
+    // Есть ли следующий элемент массива; false - массив закончился
+    bool nextElement();
+
+    // null читается как значение по умолчанию
+    qint64 readInteger();
+    double readDouble();
+    bool readBool();
+    QString readString();
+    void skip();
+
+    bool hasError() const { return failed; }
+
+private:
+    void skipSpace();
+    bool consumeLiteral(const char *literal);
+    bool consumeNull();
+    bool afterElement(char close);
+    QLatin1String numberToken();
+    void fail();
+
+    QByteArray data;
+    const char *pos;
+    const char *end;
+    bool expectFirst = false; // сразу после '{' или '[' запятая не нужна
+    bool failed = false;
+};
+
+#endif //HTTP_CLIENT_JSONREADER_H
@@ -1,25 +1,149 @@
-#include <QEventLoop>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QJsonDocument>
+#include <QNetworkDiskCache>
+#include <QPointer>
+#include <QSettings>
+#include <QStandardPaths>
 #include "Requests.h"
+#include "CborReader.h"
+#include "DtoParsers.h"
+#include "JsonReader.h"
+#include "http_client/metrics/Metrics.h"
+#include <memory>
 
 Requests::Requests(QObject* parent) : QObject(parent)
 {
-    manager = new QNetworkAccessManager(this);
+    manager = sharedManager();
 }
 
-QNetworkReply* Requests::sendRequest(const QString &url, const QUrlQuery &params, const QByteArray &verb, const QByteArray &data)
+QNetworkAccessManager* Requests::sharedManager()
 {
-    QUrl fullUrl(url);
-    fullUrl.setQuery(params);
+    // Один менеджер на процесс: все окна делят пул соединений и держат несколько запросов одновременно
+    static QPointer<QNetworkAccessManager> instance;
+    if (!instance)
+    {
+        instance = new QNetworkAccessManager(QCoreApplication::instance());
 
-    QNetworkRequest request(fullUrl);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        auto *cache = new QNetworkDiskCache(instance);
+        cache->setCacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/http");
+        cache->setMaximumCacheSize(256 * 1024 * 1024);
+        instance->setCache(cache);
+
+        // Соединение открывается заранее, чтобы первый запрос каталога не ждал установки TCP
+        const QUrl server = baseUrl();
+        if (server.scheme() == "https")
+        {
+            instance->connectToHostEncrypted(server.host(), server.port(443));
+        }
+        else
+        {
+            instance->connectToHost(server.host(), server.port(80));
+        }
+    }
+    return instance;
+}
+
+QUrl Requests::baseUrl()
+{
+    // Адрес сервера задаётся в настройках приложения (ключ server/base_url)
+    QSettings settings;
+    return QUrl(settings.value("server/base_url", "http://127.0.0.1:8080").toString());
+}
+
+QNetworkRequest Requests::makeRequest(const QString &path)
+{
+    QNetworkRequest request(baseUrl().resolved(QUrl(path)));
     request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+    // HTTP/2 согласуется через ALPN, поэтому работает только по https; по http остаётся HTTP/1.1
+    // с постоянными соединениями, которые менеджер держит открытыми между запросами.
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    // Accept-Encoding вручную не ставим: Qt сам отправляет "gzip, deflate" и распаковывает ответ,
+    // а явно заданный заголовок отключает автоматическую распаковку
+    return request;
+}
+
+static QByteArray verbOf(const QNetworkReply *reply)
+{
+    switch (reply->operation())
+    {
+        case QNetworkAccessManager::GetOperation: return "GET";
+        case QNetworkAccessManager::PostOperation: return "POST";
+        case QNetworkAccessManager::PutOperation: return "PUT";
+        case QNetworkAccessManager::DeleteOperation: return "DELETE";
+        default: return "OTHER";
+    }
+}
+
+// Фазы ответа для метрик. Qt 5 не сообщает о разрешении имени и установке соединения,
+// поэтому первая фаза (ttfb) - от отправки до заголовков ответа: ожидание соединения,
+// его установка и работа сервера вместе; download - от заголовков до конца тела
+static void measureReply(QNetworkReply *reply)
+{
+    struct Timing
+    {
+        QElapsedTimer started;
+        qint64 headersNs = -1;
+    };
+
+    const QString endpoint = Metrics::endpoint(verbOf(reply), reply->url());
+    reply->setProperty("metricsEndpoint", endpoint);
+
+    auto timing = std::make_shared<Timing>();
+    timing->started.start();
+
+    QObject::connect(reply, &QNetworkReply::metaDataChanged, reply, [timing]() {
+        if (timing->headersNs < 0)
+        {
+            timing->headersNs = timing->started.nsecsElapsed();
+        }
+    });
+    // Подключается первым, поэтому время обработчиков ответа в замер не входит
+    QObject::connect(reply, &QNetworkReply::finished, reply, [reply, endpoint, timing]() {
+        const qint64 totalNs = timing->started.nsecsElapsed();
+        Metrics &metrics = Metrics::shared();
+
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            metrics.record(endpoint + " failed", totalNs / 1000);
+            return;
+        }
+        if (reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool())
+        {
+            metrics.record(endpoint + " cache", totalNs / 1000);
+            return;
+        }
+
+        const qint64 headersNs = timing->headersNs < 0 ? totalNs : timing->headersNs;
+        metrics.record(endpoint + " total", totalNs / 1000);
+        metrics.record(endpoint + " ttfb", headersNs / 1000);
+        metrics.record(endpoint + " download", (totalNs - headersNs) / 1000);
+    });
+}
+
+void Requests::sendRequest(const QString &url, const QUrlQuery &params, const QByteArray &verb, const QByteArray &data,
+                           QObject *context, ReplyHandler handler, bool parseJson)
+{
+    QNetworkRequest request = makeRequest(url);
+    QUrl fullUrl = request.url();
+    fullUrl.setQuery(params);
+    request.setUrl(fullUrl);
+    if (!data.isEmpty())
+    {
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    }
+    if (!parseJson)
+    {
+        // Двоичный формат разбирается быстрее текста; сервер без поддержки CBOR ответит JSON
+        request.setRawHeader("Accept", "application/cbor, application/json;q=0.9");
+    }
 
     QNetworkReply *reply = nullptr;
     if (verb == "GET")
     {
-        reply = manager->get(request);
+        attachToGet(request, parseJson, context, std::move(handler));
+        return;
     }
     else if (verb == "POST")
     {
@@ -36,18 +160,78 @@ QNetworkReply* Requests::sendRequest(const QString &url, const QUrlQuery &params
     else
     {
         qDebug() << "Unsupported HTTP verb:" << verb;
-        return nullptr;
+        handler(nullptr);
+        return;
+    }
+
+    watchReply(reply, parseJson, context, std::move(handler));
+}
+
+void Requests::watchReply(QNetworkReply *reply, bool parseJson, QObject *context, ReplyHandler handler)
+{
+    // Ответ живёт не дольше владельца Requests: при его удалении незавершённые запросы прерываются
+    reply->setParent(this);
+    measureReply(reply);
+
+    QPointer<QObject> guard(context);
+    const bool hasContext = context != nullptr;
+
+    connect(reply, &QNetworkReply::finished, this, [reply, parseJson, guard, hasContext, handler]() {
+        processReply(reply, parseJson);
+        if (!hasContext || guard)
+        {
+            handler(reply);
+        }
+        reply->deleteLater();
+    });
+}
+
+void Requests::attachToGet(const QNetworkRequest &request, bool parseJson, QObject *context, ReplyHandler handler)
+{
+    // Таблица общая для всех экземпляров Requests, как и менеджер: одинаковые GET-запросы,
+    // отправленные до прихода ответа, ждут один и тот же ответ сервера
+    static QHash<QString, QNetworkReply *> inFlight;
+
+    const QString key = (parseJson ? "json " : "raw ") + request.url().toString(QUrl::FullyEncoded);
+    QNetworkReply *reply = inFlight.value(key);
+    if (!reply)
+    {
+        // Общий ответ принадлежит менеджеру, а не окну: закрытие одного окна не обрывает запрос для других
+        reply = manager->get(request);
+        inFlight.insert(key, reply);
+        measureReply(reply);
+
+        // Подключается раньше обработчиков, поэтому ответ разбирается один раз до их вызова
+        connect(reply, &QNetworkReply::finished, manager, [reply, key, parseJson]() {
+            inFlight.remove(key);
+            processReply(reply, parseJson);
+            reply->deleteLater();
+        });
     }
 
-    QEventLoop loop;
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+    QPointer<QObject> guard(context);
+    const bool hasContext = context != nullptr;
+
+    connect(reply, &QNetworkReply::finished, this, [reply, guard, hasContext, handler]() {
+        if (!hasContext || guard)
+        {
+            handler(reply);
+        }
+    });
+}
 
+void Requests::sendRequest(const QString &url, QObject *context, ReplyHandler handler)
+{
+    sendRequest(url, QUrlQuery(), "GET", QByteArray(), context, std::move(handler));
+}
+
+void Requests::processReply(QNetworkReply *reply, bool parseJson)
+{
     if (reply->error() != QNetworkReply::NoError)
     {
         qDebug() << "HTTP Error:" << reply->errorString();
         reply->setProperty("success", false);
-        return reply;
+        return;
     }
 
     int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
@@ -55,12 +239,21 @@ QNetworkReply* Requests::sendRequest(const QString &url, const QUrlQuery &params
     {
         qDebug() << "HTTP Status Error:" << status;
         reply->setProperty("success", false);
-        return reply;
+        return;
+    }
+
+    if (!parseJson)
+    {
+        // Тело забирается один раз: QByteArray разделяемый, все ожидающие ответа читают один буфер
+        reply->setProperty("body", reply->readAll());
+        reply->setProperty("success", true);
+        return;
     }
 
     QByteArray responseData = reply->readAll();
     if (!responseData.isEmpty())
     {
+        Metrics::ScopedTimer timer(reply->property("metricsEndpoint").toString() + " parse");
         QJsonParseError parseError;
         QJsonDocument doc = QJsonDocument::fromJson(responseData, &parseError);
 
@@ -68,7 +261,7 @@ QNetworkReply* Requests::sendRequest(const QString &url, const QUrlQuery &params
         {
             qDebug() << "JSON Parse Error:" << parseError.errorString();
             reply->setProperty("success", false);
-            return reply;
+            return;
         }
 
         if (doc.isArray())
@@ -82,22 +275,11 @@ QNetworkReply* Requests::sendRequest(const QString &url, const QUrlQuery &params
     }
 
     reply->setProperty("success", true);
-    return reply;
 }
 
-QJsonArray Requests::getAllProducts()
+static QJsonArray productsFromReply(QNetworkReply *reply)
 {
-    QNetworkReply* reply = sendRequest("http://127.0.0.1:8080/products");
-
-    if (!reply || !reply->property("success").toBool())
-    {
-        qDebug() << "Error: Failed to get products";
-        reply->deleteLater();
-        return QJsonArray();
-    }
-
     QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
 
     if (response.contains("products") && response["products"].isArray())
     {
@@ -107,288 +289,504 @@ QJsonArray Requests::getAllProducts()
     return QJsonArray();
 }
 
-QJsonArray Requests::getSortedProducts(const QString &field, const QString &order)
+// Типизированные ответы приходят в CBOR, если сервер его поддерживает, иначе в JSON
+template <typename T>
+static bool parseBody(QNetworkReply *reply, T &out)
 {
-    QUrlQuery params;
-    params.addQueryItem("sort_by", field + "_" + order.toLower());
+    Metrics::ScopedTimer timer(reply->property("metricsEndpoint").toString() + " parse");
+    const QByteArray body = reply->property("body").toByteArray();
+    if (reply->header(QNetworkRequest::ContentTypeHeader).toString().startsWith("application/cbor"))
+    {
+        return Dto::parse<CborReader>(body, out);
+    }
+    return Dto::parse<JsonReader>(body, out);
+}
 
-    QNetworkReply* reply = sendRequest("http://127.0.0.1:8080/products", params);
+void Requests::getAllProductsAsync(QObject *context, ArrayCallback callback)
+{
+    sendRequest("/products", context, [callback](QNetworkReply *reply) {
+        if (!reply || !reply->property("success").toBool())
+        {
+            qDebug() << "Error: Failed to get products";
+            callback(QJsonArray());
+            return;
+        }
 
-    if (!reply || !reply->property("success").toBool())
+        callback(productsFromReply(reply));
+    });
+}
+
+void Requests::getProductsPageAsync(const QString &sortBy, const QString &after, int limit, QObject *context, PageCallback callback)
+{
+    QUrlQuery params;
+    params.addQueryItem("limit", QString::number(limit));
+    if (!sortBy.isEmpty())
     {
-        qDebug() << "Error: Failed to get sorted products";
-        reply->deleteLater();
-        return QJsonArray();
+        params.addQueryItem("sort_by", sortBy);
+    }
+    if (!after.isEmpty())
+    {
+        params.addQueryItem("after", after);
     }
 
-    QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
+    sendRequest("/products", params, "GET", QByteArray(), context, [callback](QNetworkReply *reply) {
+        Dto::ProductsPage page;
+        if (!reply || !reply->property("success").toBool() ||
+            !parseBody(reply, page))
+        {
+            qDebug() << "Error: Failed to get products page";
+            callback(false, Dto::ProductsPage());
+            return;
+        }
 
-    if (response.contains("products") && response["products"].isArray())
+        callback(true, page);
+    }, false);
+}
+
+void Requests::getCatalogVersionAsync(const QString &knownVersion, QObject *context, VersionCallback callback)
+{
+    // Мимо дискового кэша: ответ всегда нужен свежий, а 304 обрабатывается здесь же
+    QNetworkRequest request = makeRequest("/products/version");
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+    if (!knownVersion.isEmpty())
     {
-        return response["products"].toArray();
+        request.setRawHeader("If-None-Match", '"' + knownVersion.toUtf8() + '"');
     }
 
-    return QJsonArray();
+    watchReply(manager->get(request), true, context, [knownVersion, callback](QNetworkReply *reply) {
+        if (!reply->property("success").toBool())
+        {
+            qDebug() << "Error: Failed to get catalog version";
+            callback(false, false, knownVersion);
+            return;
+        }
+
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304)
+        {
+            callback(true, false, knownVersion);
+            return;
+        }
+
+        const QString version = reply->property("json").toJsonObject().value("version").toString();
+        callback(!version.isEmpty(), version != knownVersion, version);
+    });
 }
 
-QJsonArray Requests::searchProducts(const QString &query)
+void Requests::getCatalogChangesAsync(const QString &since, QObject *context, ChangesCallback callback)
 {
     QUrlQuery params;
-    params.addQueryItem("query", query);
+    params.addQueryItem("since", since);
 
-    QNetworkReply* reply = sendRequest("http://127.0.0.1:8080/products/search", params);
+    sendRequest("/products/changes", params, "GET", QByteArray(), context, [callback](QNetworkReply *reply) {
+        Dto::CatalogChanges changes;
+        if (!reply || !reply->property("success").toBool() ||
+            !parseBody(reply, changes))
+        {
+            qDebug() << "Error: Failed to get catalog changes";
+            callback(false, Dto::CatalogChanges());
+            return;
+        }
 
-    if (!reply || !reply->property("success").toBool())
-    {
-        qDebug() << "Error: Failed to search products";
-        reply->deleteLater();
-        return QJsonArray();
-    }
+        callback(true, changes);
+    }, false);
+}
 
-    QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
+EventStream *Requests::customerEvents(int customerId, QObject *parent)
+{
+    return new EventStream(manager, makeRequest(QString("/customers/%1/events").arg(customerId)), parent);
+}
 
-    if (response.contains("products") && response["products"].isArray())
-    {
-        return response["products"].toArray();
-    }
+bool Requests::parseCart(const QByteArray &json, Dto::Cart &cart)
+{
+    return Dto::parse<JsonReader>(json, cart);
+}
 
-    return QJsonArray();
+void Requests::getProductImageAsync(const QString &imageUrl, QObject *context, BytesCallback callback)
+{
+    QNetworkRequest request = makeRequest(imageUrl);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+
+    watchReply(manager->get(request), false, context, [callback](QNetworkReply *reply) {
+        if (!reply->property("success").toBool())
+        {
+            qDebug() << "Error: Failed to get product image";
+            callback(QByteArray());
+            return;
+        }
+
+        callback(reply->property("body").toByteArray());
+    });
 }
 
-QJsonObject Requests::getCustomerInfo(int customerId)
+void Requests::getSortedProductsAsync(const QString &field, const QString &order, QObject *context, ArrayCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            QString("http://127.0.0.1:8080/customers/%1").arg(customerId),
-            QUrlQuery(),
-            "GET"
-    );
+    QUrlQuery params;
+    params.addQueryItem("sort_by", field + "_" + order.toLower());
 
-    if (!reply || !reply->property("success").toBool())
-    {
-        qDebug() << "Error: Failed to get customer info";
-        reply->deleteLater();
-        return QJsonObject();
-    }
+    sendRequest("/products", params, "GET", QByteArray(), context, [callback](QNetworkReply *reply) {
+        if (!reply || !reply->property("success").toBool())
+        {
+            qDebug() << "Error: Failed to get sorted products";
+            callback(QJsonArray());
+            return;
+        }
 
-    QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
-    return response;
+        callback(productsFromReply(reply));
+    });
 }
 
-bool Requests::updateCustomerInfo(int customerId, const QJsonObject &data)
+void Requests::searchProductsAsync(const QString &query, QObject *context, ArrayCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            QString("http://127.0.0.1:8080/customers/%1").arg(customerId),
-            QUrlQuery(),
-            "PUT",
-            QJsonDocument(data).toJson()
-    );
+    QUrlQuery params;
+    params.addQueryItem("query", query);
 
-    if (!reply)
-    {
-        qDebug() << "Error: Request failed";
-        return false;
-    }
+    sendRequest("/products/search", params, "GET", QByteArray(), context, [callback](QNetworkReply *reply) {
+        if (!reply || !reply->property("success").toBool())
+        {
+            qDebug() << "Error: Failed to search products";
+            callback(QJsonArray());
+            return;
+        }
 
-    bool success = reply->property("success").toBool();
-    reply->deleteLater();
-    return success;
+        callback(productsFromReply(reply));
+    });
 }
 
+void Requests::getCustomerInfoAsync(int customerId, QObject *context, ObjectCallback callback)
+{
+    sendRequest(QString("/customers/%1").arg(customerId), context, [callback](QNetworkReply *reply) {
+        if (!reply || !reply->property("success").toBool())
+        {
+            qDebug() << "Error: Failed to get customer info";
+            callback(QJsonObject());
+            return;
+        }
 
+        callback(reply->property("json").toJsonObject());
+    });
+}
 
-QJsonObject Requests::getCart(int customerId)
+void Requests::updateCustomerInfoAsync(int customerId, const QJsonObject &data, QObject *context, StatusCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            QString("http://127.0.0.1:8080/customers/%1/cart").arg(customerId),
+    sendRequest(
+            QString("/customers/%1").arg(customerId),
             QUrlQuery(),
-            "GET"
+            "PUT",
+            QJsonDocument(data).toJson(),
+            context,
+            [callback](QNetworkReply *reply) {
+                if (!reply)
+                {
+                    qDebug() << "Error: Request failed";
+                    callback(false);
+                    return;
+                }
+
+                callback(reply->property("success").toBool());
+            }
     );
+}
 
-    if (!reply || !reply->property("success").toBool())
+void Requests::getDiscountsAsync(const QString &knownVersion, QObject *context, DiscountsCallback callback)
+{
+    // Копию ступеней держит DiscountTable, поэтому дисковый кэш не нужен: 304 обрабатывается здесь же
+    QNetworkRequest request = makeRequest("/discounts");
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+    request.setRawHeader("Accept", "application/cbor, application/json;q=0.9");
+    if (!knownVersion.isEmpty())
     {
-        qDebug() << "Error: Failed to get cart";
-        reply->deleteLater();
-        return QJsonObject();
+        request.setRawHeader("If-None-Match", '"' + knownVersion.toUtf8() + '"');
     }
 
-    QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
-    return response;
+    watchReply(manager->get(request), false, context, [knownVersion, callback](QNetworkReply *reply) {
+        if (!reply->property("success").toBool())
+        {
+            qDebug() << "Error: Failed to get discounts";
+            callback(false, false, knownVersion, Dto::DiscountsList());
+            return;
+        }
+
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304)
+        {
+            callback(true, false, knownVersion, Dto::DiscountsList());
+            return;
+        }
+
+        Dto::DiscountsList list;
+        if (!parseBody(reply, list))
+        {
+            qDebug() << "Error: Failed to parse discounts";
+            callback(false, false, knownVersion, Dto::DiscountsList());
+            return;
+        }
+
+        const QString version = QString::fromUtf8(reply->rawHeader("ETag")).remove('"');
+        callback(true, true, version, list);
+    });
+}
+
+void Requests::getCartAsync(int customerId, QObject *context, CartCallback callback)
+{
+    sendRequest(QString("/customers/%1/cart").arg(customerId), QUrlQuery(), "GET", QByteArray(), context,
+                [callback](QNetworkReply *reply) {
+        Dto::Cart cart;
+        if (!reply || !reply->property("success").toBool() ||
+            !parseBody(reply, cart))
+        {
+            qDebug() << "Error: Failed to get cart";
+            callback(false, Dto::Cart());
+            return;
+        }
+
+        callback(true, cart);
+    }, false);
 }
 
-QJsonObject Requests::addToCart(int customerId, int productId, int quantity)
+void Requests::addToCartAsync(int customerId, int productId, int quantity, QObject *context, ObjectCallback callback)
 {
     QJsonObject payload;
     payload["ProductID"] = productId;
     payload["Quantity"] = quantity;
 
-    QNetworkReply* reply = sendRequest(
-            QString("http://127.0.0.1:8080/customers/%1/cart/items").arg(customerId),
+    sendRequest(
+            QString("/customers/%1/cart/items").arg(customerId),
             QUrlQuery(),
             "POST",
-            QJsonDocument(payload).toJson()
+            QJsonDocument(payload).toJson(),
+            context,
+            [callback](QNetworkReply *reply) {
+                if (!reply || !reply->property("success").toBool())
+                {
+                    qDebug() << "Error: Add to cart request failed";
+                    callback(QJsonObject());
+                    return;
+                }
+
+                callback(reply->property("json").toJsonObject());
+            }
     );
+}
 
-    if (!reply || !reply->property("success").toBool())
+void Requests::applyCartOperationsAsync(int customerId, const QVector<Dto::CartOperation> &operations, QObject *context,
+                                        CartCallback callback)
+{
+    QJsonArray items;
+    for (const Dto::CartOperation &operation : operations)
     {
-        qDebug() << "Error: Add to cart request failed";
-        reply->deleteLater();
-        return QJsonObject();
+        items.append(QJsonObject{{"ProductID", operation.productId}, {"Quantity", operation.quantity}});
     }
 
-    QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
-    return response;
+    sendRequest(
+            QString("/customers/%1/cart/batch").arg(customerId),
+            QUrlQuery(),
+            "POST",
+            QJsonDocument(QJsonObject{{"operations", items}}).toJson(QJsonDocument::Compact),
+            context,
+            [callback](QNetworkReply *reply) {
+                Dto::Cart cart;
+                if (!reply || !reply->property("success").toBool() ||
+                    !parseBody(reply, cart))
+                {
+                    qDebug() << "Error: Cart batch failed";
+                    callback(false, Dto::Cart());
+                    return;
+                }
+
+                callback(true, cart);
+            },
+            false
+    );
 }
 
-bool Requests::removeFromCart(int customerId, int productId)
+void Requests::removeFromCartAsync(int customerId, int productId, QObject *context, StatusCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            QString("http://127.0.0.1:8080/customers/%1/cart/%2").arg(customerId).arg(productId),
+    sendRequest(
+            QString("/customers/%1/cart/%2").arg(customerId).arg(productId),
             QUrlQuery(),
-            "DELETE"
+            "DELETE",
+            QByteArray(),
+            context,
+            [callback](QNetworkReply *reply) {
+                if (!reply)
+                {
+                    qDebug() << "Error: Request failed";
+                    callback(false);
+                    return;
+                }
+
+                callback(reply->property("success").toBool());
+            }
     );
-
-    if (!reply)
-    {
-        qDebug() << "Error: Request failed";
-        return false;
-    }
-
-    bool success = reply->property("success").toBool();
-    reply->deleteLater();
-    return success;
 }
 
-bool Requests::checkout(int customerId)
+void Requests::checkoutAsync(int customerId, QObject *context, StatusCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            QString("http://127.0.0.1:8080/customers/%1/checkout").arg(customerId),
+    sendRequest(
+            QString("/customers/%1/checkout").arg(customerId),
             QUrlQuery(),
-            "POST"
+            "POST",
+            QByteArray(),
+            context,
+            [callback](QNetworkReply *reply) {
+                if (!reply)
+                {
+                    qDebug() << "Error: Request failed";
+                    callback(false);
+                    return;
+                }
+
+                callback(reply->property("success").toBool());
+            }
     );
+}
 
-    if (!reply)
+void Requests::getOrdersAsync(int customerId, const QString &before, int limit, QObject *context,
+                              OrdersPageCallback callback)
+{
+    QUrlQuery params;
+    params.addQueryItem("limit", QString::number(limit));
+    if (!before.isEmpty())
     {
-        qDebug() << "Error: Request failed";
-        return false;
+        params.addQueryItem("before", before);
     }
 
-    bool success = reply->property("success").toBool();
-    reply->deleteLater();
-    return success;
+    sendRequest(QString("/customers/%1/orders").arg(customerId), params, "GET", QByteArray(), context,
+                [callback](QNetworkReply *reply) {
+        Dto::OrdersPage page;
+        if (!reply || !reply->property("success").toBool() ||
+            !parseBody(reply, page))
+        {
+            qDebug() << "Error: Failed to get orders";
+            callback(false, Dto::OrdersPage());
+            return;
+        }
+
+        callback(true, page);
+    }, false);
 }
 
-QJsonArray Requests::getOrders(int customerId)
+void Requests::getOrderHistoryAsync(int customerId, QObject *context, TransactionsCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            QString("http://127.0.0.1:8080/customers/%1/orders").arg(customerId),
-            QUrlQuery(),
-            "GET"
-    );
+    sendRequest(QString("/customers/%1/orders").arg(customerId), QUrlQuery(), "GET", QByteArray(), context,
+                [callback](QNetworkReply *reply) {
+        Dto::TransactionsList list;
+        if (!reply || !reply->property("success").toBool() ||
+            !parseBody(reply, list))
+        {
+            qDebug() << "Error: Failed to get order history";
+            callback(false, Dto::TransactionsList());
+            return;
+        }
 
-    if (!reply || !reply->property("success").toBool())
-    {
-        qDebug() << "Error: Failed to get orders";
-        reply->deleteLater();
-        return QJsonArray();
-    }
+        callback(true, list);
+    }, false);
+}
 
-    QJsonArray response = reply->property("json").toJsonArray();
-    reply->deleteLater();
-    return response;
+void Requests::getOrderAsync(int orderId, QObject *context, TransactionCallback callback)
+{
+    sendRequest(QString("/orders/%1").arg(orderId), QUrlQuery(), "GET", QByteArray(), context,
+                [callback](QNetworkReply *reply) {
+        Dto::Transaction order;
+        if (!reply || !reply->property("success").toBool() ||
+            !parseBody(reply, order))
+        {
+            qDebug() << "Error: Failed to get order";
+            callback(false, Dto::Transaction());
+            return;
+        }
+
+        callback(true, order);
+    }, false);
 }
 
-QJsonObject Requests::login(const QJsonObject &credentials)
+void Requests::loginAsync(const QJsonObject &credentials, QObject *context, ObjectCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            "http://127.0.0.1:8080/login",
+    sendRequest(
+            "/login",
             QUrlQuery(),
             "POST",
-            QJsonDocument(credentials).toJson()
+            QJsonDocument(credentials).toJson(),
+            context,
+            [callback](QNetworkReply *reply) {
+                if (!reply || !reply->property("success").toBool())
+                {
+                    if (reply)
+                    {
+                        qDebug() << "Login error:" << reply->errorString();
+                    }
+                    callback(QJsonObject{{"error", "Login failed"}});
+                    return;
+                }
+
+                callback(reply->property("json").toJsonObject());
+            }
     );
-
-    if (!reply || !reply->property("success").toBool())
-    {
-        qDebug() << "Login error:" << reply->errorString();
-        qDebug() << "Response:" << reply->readAll();
-        reply->deleteLater();
-        return QJsonObject{{"error", "Login failed"}};
-    }
-
-    QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
-    return response;
 }
 
-QJsonObject Requests::registerCustomer(const QJsonObject &customerData)
+void Requests::registerCustomerAsync(const QJsonObject &customerData, QObject *context, ObjectCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            "http://127.0.0.1:8080/register",
+    sendRequest(
+            "/register",
             QUrlQuery(),
             "POST",
-            QJsonDocument(customerData).toJson()
+            QJsonDocument(customerData).toJson(),
+            context,
+            [callback](QNetworkReply *reply) {
+                if (!reply || !reply->property("success").toBool())
+                {
+                    qDebug() << "Error: Registration failed";
+                    callback(QJsonObject());
+                    return;
+                }
+
+                callback(reply->property("json").toJsonObject());
+            }
     );
-
-    if (!reply || !reply->property("success").toBool())
-    {
-        qDebug() << "Error: Registration failed";
-        reply->deleteLater();
-        return QJsonObject();
-    }
-
-    QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
-    return response;
 }
 
-QJsonObject Requests::placeOrder(int customerId, const QJsonObject &orderData)
+void Requests::placeOrderAsync(int customerId, const QJsonObject &orderData, QObject *context, TransactionCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            QString("http://127.0.0.1:8080/customers/%1/orders").arg(customerId),
+    sendRequest(
+            QString("/customers/%1/orders").arg(customerId),
             QUrlQuery(),
             "POST",
-            QJsonDocument(orderData).toJson()
+            QJsonDocument(orderData).toJson(),
+            context,
+            [callback](QNetworkReply *reply) {
+                Dto::Transaction transaction;
+                if (!reply || !reply->property("success").toBool() ||
+                    !parseBody(reply, transaction))
+                {
+                    qDebug() << "Error: Order request failed";
+                    callback(false, Dto::Transaction());
+                    return;
+                }
+
+                callback(true, transaction);
+            },
+            false
     );
-
-    if (!reply || !reply->property("success").toBool())
-    {
-        qDebug() << "Error: Order request failed";
-        reply->deleteLater();
-        return QJsonObject();
-    }
-
-    QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
-    return response;
 }
 
-QJsonObject Requests::clearCart(int customerId)
+void Requests::clearCartAsync(int customerId, QObject *context, ObjectCallback callback)
 {
-    QNetworkReply* reply = sendRequest(
-            QString("http://127.0.0.1:8080/customers/%1/cart").arg(customerId),
+    sendRequest(
+            QString("/customers/%1/cart").arg(customerId),
             QUrlQuery(),
-            "DELETE"
+            "DELETE",
+            QByteArray(),
+            context,
+            [callback](QNetworkReply *reply) {
+                if (!reply || !reply->property("success").toBool())
+                {
+                    qDebug() << "Error: Clear cart request failed";
+                    callback(QJsonObject());
+                    return;
+                }
+
+                callback(reply->property("json").toJsonObject());
+            }
     );
-
-    if (!reply || !reply->property("success").toBool())
-    {
-        qDebug() << "Error: Clear cart request failed";
-        reply->deleteLater();
-        return QJsonObject();
-    }
-
-    QJsonObject response = reply->property("json").toJsonObject();
-    reply->deleteLater();
-    return response;
 }
-
-
-
-
-
-
-
@@ -7,7 +7,10 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <limits>
+#include <functional>
 #include <QUrlQuery>
+#include "Dto.h"
+#include "EventStream.h"
 
 
 class Requests : public QObject
@@ -15,40 +18,95 @@ class Requests : public QObject
     Q_OBJECT
 
 public:
+    using ArrayCallback = std::function<void(const QJsonArray &)>;
+    using ObjectCallback = std::function<void(const QJsonObject &)>;
+    using StatusCallback = std::function<void(bool)>;
+    using BytesCallback = std::function<void(const QByteArray &)>;
+    // Типизированные ответы: ok == false - запрос не удался или тело не разобралось
+    using PageCallback = std::function<void(bool ok, const Dto::ProductsPage &page)>;
+    using CartCallback = std::function<void(bool ok, const Dto::Cart &cart)>;
+    using TransactionCallback = std::function<void(bool ok, const Dto::Transaction &transaction)>;
+    // changed == false - версия совпала с известной клиенту (ответ 304)
+    using VersionCallback = std::function<void(bool ok, bool changed, const QString &version)>;
+    using ChangesCallback = std::function<void(bool ok, const Dto::CatalogChanges &changes)>;
+    using OrdersPageCallback = std::function<void(bool ok, const Dto::OrdersPage &page)>;
+    using TransactionsCallback = std::function<void(bool ok, const Dto::TransactionsList &list)>;
+    // changed == false - ступени не менялись с версии knownVersion (ответ 304), list пуст
+    using DiscountsCallback = std::function<void(bool ok, bool changed, const QString &version, const Dto::DiscountsList &list)>;
+
      explicit Requests(QObject* parent = nullptr);
 
+    // Адрес сервера; пути всех запросов задаются относительно него
+    static QUrl baseUrl();
+
+    // Асинхронный API: обработчик вызывается из цикла событий, когда ответ получен.
+    // Если context уничтожен до ответа, обработчик не вызывается (context == nullptr - вызывается всегда).
+
     // Товары
-    QJsonArray getAllProducts();
-    QJsonArray getSortedProducts(const QString &field, const QString &order);
-    QJsonArray searchProducts(const QString &query);
+    void getAllProductsAsync(QObject *context, ArrayCallback callback);
+    // Страница каталога; sortBy в формате сервера ("retail_price_desc"), after - курсор из предыдущей страницы
+    void getProductsPageAsync(const QString &sortBy, const QString &after, int limit, QObject *context, PageCallback callback);
+    // Версия каталога: меняется при любом изменении товаров. knownVersion отправляется в If-None-Match
+    void getCatalogVersionAsync(const QString &knownVersion, QObject *context, VersionCallback callback);
+    // Изменения каталога после версии since; при hasMore запрашиваются дальше с changes.version
+    void getCatalogChangesAsync(const QString &since, QObject *context, ChangesCallback callback);
+    // Картинка товара (сырые байты); imageUrl - поле ImageUrl из ответа /products.
+    // Ответ сервера кэшируется на диске, поэтому неизменившаяся картинка по сети повторно не передаётся
+    void getProductImageAsync(const QString &imageUrl, QObject *context, BytesCallback callback);
+    void getSortedProductsAsync(const QString &field, const QString &order, QObject *context, ArrayCallback callback);
+    void searchProductsAsync(const QString &query, QObject *context, ArrayCallback callback);
 
     // Профиль
-    QJsonObject getCustomerInfo(int customerId);
-    bool updateCustomerInfo(int customerId, const QJsonObject &data);
+    void getCustomerInfoAsync(int customerId, QObject *context, ObjectCallback callback);
+    void updateCustomerInfoAsync(int customerId, const QJsonObject &data, QObject *context, StatusCallback callback);
 
     // Корзина
-    QJsonObject getCart(int customerId);
-    QJsonObject clearCart(int customerId);
-    QJsonObject addToCart(int customerId, int productId, int quantity);
-    bool removeFromCart(int customerId, int productId);
-    bool checkout(int customerId);
+    // Ступени скидок, по которым сервер считает скидку корзины; knownVersion отправляется в If-None-Match
+    void getDiscountsAsync(const QString &knownVersion, QObject *context, DiscountsCallback callback);
+    void getCartAsync(int customerId, QObject *context, CartCallback callback);
+    void clearCartAsync(int customerId, QObject *context, ObjectCallback callback);
+    void addToCartAsync(int customerId, int productId, int quantity, QObject *context, ObjectCallback callback);
+    void removeFromCartAsync(int customerId, int productId, QObject *context, StatusCallback callback);
+    // Пакет изменений одной транзакцией на сервере; в ответе - корзина после пакета
+    void applyCartOperationsAsync(int customerId, const QVector<Dto::CartOperation> &operations, QObject *context,
+                                  CartCallback callback);
+    void checkoutAsync(int customerId, QObject *context, StatusCallback callback);
 
     // Заказы
-    QJsonArray getOrders(int customerId);
-    QJsonObject placeOrder(int customerId, const QJsonObject &orderData);
+    // Страница истории заказов от новых к старым; before - курсор из предыдущей страницы
+    void getOrdersAsync(int customerId, const QString &before, int limit, QObject *context, OrdersPageCallback callback);
+    // Все заказы покупателя со строками одним ответом
+    void getOrderHistoryAsync(int customerId, QObject *context, TransactionsCallback callback);
+    // Заказ со строками
+    void getOrderAsync(int orderId, QObject *context, TransactionCallback callback);
+    void placeOrderAsync(int customerId, const QJsonObject &orderData, QObject *context, TransactionCallback callback);
+
+    // События покупателя с сервера: "cart" - новое содержимое корзины (как в getCartAsync),
+    // "catalog" - каталог изменился, "resync" - часть событий потеряна. Поток ещё не запущен, владелец - parent
+    EventStream *customerEvents(int customerId, QObject *parent);
+    // Разбор корзины из события "cart"
+    static bool parseCart(const QByteArray &json, Dto::Cart &cart);
 
     // Авторизация
-    QJsonObject login(const QJsonObject &credentials);
-    QJsonObject registerCustomer(const QJsonObject &customerData);
-
+    void loginAsync(const QJsonObject &credentials, QObject *context, ObjectCallback callback);
+    void registerCustomerAsync(const QJsonObject &customerData, QObject *context, ObjectCallback callback);
 
 private:
+    using ReplyHandler = std::function<void(QNetworkReply *)>;
+
     QNetworkAccessManager* manager;
 
-    QNetworkReply* sendRequest(const QString &url, const QUrlQuery &params = QUrlQuery(), const QByteArray &verb = "GET", const QByteArray &data = QByteArray());
+    static QNetworkAccessManager* sharedManager();
+    static QNetworkRequest makeRequest(const QString &path);
+
+    // url - путь относительно baseUrl(). parseJson == false - тело не разбирается в QJsonDocument,
+    // а кладётся как есть в свойство "body" для типизированных парсеров; такие запросы просят у сервера CBOR
+    void sendRequest(const QString &url, const QUrlQuery &params, const QByteArray &verb, const QByteArray &data,
+                     QObject *context, ReplyHandler handler, bool parseJson = true);
+    void sendRequest(const QString &url, QObject *context, ReplyHandler handler);
+    void attachToGet(const QNetworkRequest &request, bool parseJson, QObject *context, ReplyHandler handler);
+    void watchReply(QNetworkReply *reply, bool parseJson, QObject *context, ReplyHandler handler);
+    static void processReply(QNetworkReply *reply, bool parseJson);
 };
 
 #endif // REQUESTS_H
-
-
-
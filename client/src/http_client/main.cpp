@@ -1,6 +1,8 @@
 #include "../src/http_client/GUI/Client_GUI/MainWindow.h"
 #include "../src/http_client/GUI/Login_GUI/LoginWindow.h"
 
+#include "../src/http_client/metrics/Metrics.h"
+
 #include <QApplication>
 #include <QLoggingCategory>
 
@@ -8,6 +10,18 @@ int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
+    // Имена задают, где лежат настройки (QSettings) и дисковый кэш HTTP
+    QCoreApplication::setOrganizationName("CustomersUI");
+    QCoreApplication::setApplicationName("Client");
+
+    // CUSTOMERSUI_METRICS_FILE=путь - при выходе метрики клиента сохраняются в JSON (для терминалов без отладчика)
+    const QString metricsFile = qEnvironmentVariable("CUSTOMERSUI_METRICS_FILE");
+    if (!metricsFile.isEmpty()) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [metricsFile]() {
+            Metrics::shared().writeJson(metricsFile);
+        });
+    }
+
     // Логин-окно
     LoginWindow login;
 
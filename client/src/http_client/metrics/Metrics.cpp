@@ -0,0 +1,195 @@
+#include "Metrics.h"
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QUrl>
+#include <QtAlgorithms>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+int LatencyHistogram::bucketIndex(quint64 micros)
+{
+    // Значения меньше SubBuckets хранятся точно, дальше: номер старшего бита и следующие за ним SubBucketBits бит
+    if (micros < quint64(SubBuckets))
+    {
+        return int(micros);
+    }
+
+    const int highestBit = qMin(63 - qCountLeadingZeroBits(micros), MaxValueBits);
+    if (highestBit == MaxValueBits)
+    {
+        return BucketCount - 1;
+    }
+    const int shift = highestBit - SubBucketBits;
+    const int subBucket = int((micros >> shift) & (SubBuckets - 1));
+    return (shift + 1) * SubBuckets + subBucket;
+}
+
+quint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < SubBuckets)
+    {
+        return quint64(index);
+    }
+
+    const int shift = index / SubBuckets - 1;
+    const quint64 lower = quint64(SubBuckets + index % SubBuckets) << shift;
+    return lower + (quint64(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 micros)
+{
+    const quint64 value = quint64(qMax<qint64>(micros, 0));
+
+    buckets[bucketIndex(value)].fetchAndAddRelaxed(1);
+    count.fetchAndAddRelaxed(1);
+    sum.fetchAndAddRelaxed(value);
+
+    quint64 current = max.loadRelaxed();
+    while (value > current && !max.testAndSetRelaxed(current, value, current))
+    {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (QAtomicInteger<quint64> &bucket : buckets)
+    {
+        bucket.storeRelaxed(0);
+    }
+    count.storeRelaxed(0);
+    sum.storeRelaxed(0);
+    max.storeRelaxed(0);
+}
+
+double LatencyHistogram::percentileMs(const QVector<quint64> &counts, quint64 total, double fraction) const
+{
+    // Верхняя граница корзины, в которую попало нужное по счёту значение, но не больше максимума
+    const quint64 rank = qMax<quint64>(1, quint64(fraction * total + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < counts.size(); ++i)
+    {
+        seen += counts.at(i);
+        if (seen >= rank)
+        {
+            return qMin(bucketUpperBound(i), max.loadRelaxed()) / 1000.0;
+        }
+    }
+    return max.loadRelaxed() / 1000.0;
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+    // Снимок не атомарен целиком: запись, идущая одновременно, может попасть в часть счётчиков.
+    // Для обзора это не важно, а количество берётся по корзинам, чтобы перцентили сходились
+    QVector<quint64> counts(BucketCount);
+    quint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i)
+    {
+        counts[i] = buckets[i].loadRelaxed();
+        total += counts.at(i);
+    }
+
+    Summary result;
+    if (total == 0)
+    {
+        return result;
+    }
+
+    result.count = total;
+    result.meanMs = sum.loadRelaxed() / 1000.0 / total;
+    result.p50Ms = percentileMs(counts, total, 0.50);
+    result.p90Ms = percentileMs(counts, total, 0.90);
+    result.p99Ms = percentileMs(counts, total, 0.99);
+    result.maxMs = max.loadRelaxed() / 1000.0;
+    return result;
+}
+
+Metrics &Metrics::shared()
+{
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::~Metrics()
+{
+    qDeleteAll(histograms);
+}
+
+LatencyHistogram &Metrics::histogram(const QString &name)
+{
+    QMutexLocker locker(&mutex);
+    LatencyHistogram *&histogram = histograms[name];
+    if (!histogram)
+    {
+        histogram = new LatencyHistogram;
+    }
+    return *histogram;
+}
+
+QMap<QString, LatencyHistogram::Summary> Metrics::summaries() const
+{
+    QMutexLocker locker(&mutex);
+    QMap<QString, LatencyHistogram::Summary> result;
+    for (auto it = histograms.constBegin(); it != histograms.constEnd(); ++it)
+    {
+        result.insert(it.key(), it.value()->summary());
+    }
+    return result;
+}
+
+QJsonObject Metrics::toJson() const
+{
+    QJsonObject metrics;
+    const QMap<QString, LatencyHistogram::Summary> all = summaries();
+    for (auto it = all.constBegin(); it != all.constEnd(); ++it)
+    {
+        const LatencyHistogram::Summary &summary = it.value();
+        metrics.insert(it.key(), QJsonObject{
+                {"count", double(summary.count)},
+                {"mean_ms", summary.meanMs},
+                {"p50_ms", summary.p50Ms},
+                {"p90_ms", summary.p90Ms},
+                {"p99_ms", summary.p99Ms},
+                {"max_ms", summary.maxMs}
+        });
+    }
+
+    return QJsonObject{
+            {"generated_at", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+            {"metrics", metrics}
+    };
+}
+
+bool Metrics::writeJson(const QString &fileName) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    file.write(QJsonDocument(toJson()).toJson(QJsonDocument::Indented));
+    return file.commit();
+}
+
+void Metrics::reset()
+{
+    QMutexLocker locker(&mutex);
+    for (LatencyHistogram *histogram : histograms)
+    {
+        histogram->reset();
+    }
+}
+
+QString Metrics::endpoint(const QByteArray &verb, const QUrl &url)
+{
+    static const QRegularExpression number("/\\d+(?=/|$)");
+    QString path = url.path();
+    path.replace(number, "/{id}");
+    return QString::fromLatin1(verb) + ' ' + path;
+}
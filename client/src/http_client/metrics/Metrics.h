@@ -0,0 +1,97 @@
+#ifndef HTTP_CLIENT_METRICS_H
+#define HTTP_CLIENT_METRICS_H
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+class QUrl;
+
+// Гистограмма длительностей в микросекундах. Корзины логарифмические, как в HdrHistogram:
+// каждая степень двойки делится на SubBuckets равных частей, поэтому погрешность перцентилей
+// не больше 1/SubBuckets при любом масштабе. Запись - несколько атомарных операций без блокировок,
+// её можно вести из любого потока
+class LatencyHistogram
+{
+public:
+    struct Summary
+    {
+        quint64 count = 0;
+        double meanMs = 0;
+        double p50Ms = 0;
+        double p90Ms = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+    };
+
+    LatencyHistogram();
+
+    void record(qint64 micros);
+    Summary summary() const;
+    void reset();
+
+private:
+    Q_DISABLE_COPY(LatencyHistogram)
+
+    static const int SubBucketBits = 3;
+    static const int SubBuckets = 1 << SubBucketBits;
+    static const int MaxValueBits = 40; // около 12 суток; большие значения попадают в последнюю корзину
+    static const int BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBuckets;
+
+    static int bucketIndex(quint64 micros);
+    static quint64 bucketUpperBound(int index);
+    double percentileMs(const QVector<quint64> &counts, quint64 total, double fraction) const;
+
+    QAtomicInteger<quint64> buckets[BucketCount];
+    QAtomicInteger<quint64> count;
+    QAtomicInteger<quint64> sum;
+    QAtomicInteger<quint64> max;
+};
+
+// Метрики клиента по именам: "<метод> <путь> <фаза>" для запросов к серверу, "ui: ..." для интерфейса.
+// Гистограммы создаются при первом обращении и живут до выхода из программы, поэтому ссылку на
+// часто используемую можно запомнить и писать в неё без поиска по имени
+class Metrics
+{
+public:
+    static Metrics &shared();
+
+    LatencyHistogram &histogram(const QString &name);
+    void record(const QString &name, qint64 micros) { histogram(name).record(micros); }
+
+    QMap<QString, LatencyHistogram::Summary> summaries() const;
+    QJsonObject toJson() const;
+    bool writeJson(const QString &fileName) const;
+    void reset();
+
+    // Путь запроса без параметров и числовых идентификаторов: /customers/{id}/orders
+    static QString endpoint(const QByteArray &verb, const QUrl &url);
+
+    // Замер участка кода: длительность записывается при выходе из области видимости
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(LatencyHistogram &histogram) : histogram(histogram) { timer.start(); }
+        explicit ScopedTimer(const QString &name) : ScopedTimer(Metrics::shared().histogram(name)) {}
+        ~ScopedTimer() { histogram.record(timer.nsecsElapsed() / 1000); }
+
+    private:
+        Q_DISABLE_COPY(ScopedTimer)
+
+        LatencyHistogram &histogram;
+        QElapsedTimer timer;
+    };
+
+private:
+    Metrics() = default;
+    ~Metrics();
+
+    mutable QMutex mutex; // только для поиска и создания гистограмм, запись идёт без него
+    QMap<QString, LatencyHistogram *> histograms;
+};
+
+#endif //HTTP_CLIENT_METRICS_H
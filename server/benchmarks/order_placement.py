@@ -0,0 +1,117 @@
+"""Нагрузочная проверка оформления заказов: несколько потоков одновременно оформляют заказы
+из заранее наполненных корзин по N товаров (у каждого заказа свой покупатель) во временной
+базе SQLite. Печатает пропускную способность, задержки и число SQL-запросов на заказ.
+
+    python3 server/benchmarks/order_placement.py --threads 8 --orders 400 --items 50
+"""
+import argparse
+import datetime
+import os
+import statistics
+import sys
+import tempfile
+import threading
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "http_server"))
+
+from sqlalchemy import create_engine, event
+from sqlalchemy.orm import sessionmaker
+
+import crud
+import models
+import schemas
+
+
+def make_session_factory(path: str) -> sessionmaker:
+    # timeout - сколько соединение ждёт снятия блокировки записи другим потоком
+    engine = create_engine(f"sqlite:///{path}", connect_args={"check_same_thread": False, "timeout": 60})
+    models.Base.metadata.create_all(bind=engine)
+    return sessionmaker(autocommit=False, autoflush=False, bind=engine)
+
+
+def seed(factory: sessionmaker, customers: int, items: int):
+    db = factory()
+    try:
+        db.add(models.Employee(EmployeeID=1, Name="Bench", Position="-", Phone="-", Email="bench@example.com",
+                               HireDate=datetime.date.today(), Photo=b""))
+        db.add_all(models.Product(ProductID=i, Name=f"Товар {i}", WholesalePrice=10 + i % 7,
+                                  RetailPrice=15 + i % 11, Description="") for i in range(1, items + 1))
+        db.add(models.Discount(MinQuantity=1, MaxQuantity=10 ** 6, DiscountRate=0.05, MinTotalPrice=0))
+        for customer_id in range(1, customers + 1):
+            db.add(models.Customer(CustomerID=customer_id, Name=f"Покупатель {customer_id}", Phone="-",
+                                   ContactPerson="-", Address="-", Email=f"c{customer_id}@example.com",
+                                   PasswordHash="0" * 64))
+            db.add(models.Cart(CartID=customer_id, CustomerID=customer_id))
+            db.add_all(models.CartItem(CartID=customer_id, ProductID=i, Quantity=1 + i % 3)
+                       for i in range(1, items + 1))
+        db.commit()
+    finally:
+        db.close()
+
+
+def run(threads: int, orders: int, items: int):
+    handle, path = tempfile.mkstemp(suffix=".db")
+    os.close(handle)
+    try:
+        factory = make_session_factory(path)
+        seed(factory, orders, items)
+
+        statements = [0]
+        lock = threading.Lock()
+
+        def count_statement(*args):
+            with lock:
+                statements[0] += 1
+
+        event.listen(factory.kw["bind"], "before_cursor_execute", count_statement)
+
+        latencies = []
+        errors = []
+
+        def worker(customer_ids):
+            for customer_id in customer_ids:
+                db = factory()
+                started = time.perf_counter()
+                try:
+                    crud.create_order(db, customer_id, schemas.TransactionCreate(EmployeeID=1, IsWholesale=False))
+                    elapsed = time.perf_counter() - started
+                    with lock:
+                        latencies.append(elapsed)
+                except ValueError as e:
+                    with lock:
+                        errors.append(str(e))
+                finally:
+                    db.close()
+
+        pool = [threading.Thread(target=worker, args=(range(first, orders + 1, threads),))
+                for first in range(1, threads + 1)]
+        started = time.perf_counter()
+        for thread in pool:
+            thread.start()
+        for thread in pool:
+            thread.join()
+        wall = time.perf_counter() - started
+
+        latencies.sort()
+        done = len(latencies)
+        print(f"потоков: {threads}, заказов: {done}, товаров в заказе: {items}, ошибок: {len(errors)}")
+        if done:
+            print(f"заказов в секунду: {done / wall:.1f} (за {wall:.2f} с)")
+            print(f"задержка p50: {statistics.median(latencies) * 1000:.1f} мс, "
+                  f"p95: {latencies[max(0, int(done * 0.95) - 1)] * 1000:.1f} мс, "
+                  f"max: {latencies[-1] * 1000:.1f} мс")
+            print(f"SQL-запросов на заказ: {statements[0] / done:.1f}")
+        for error in errors[:3]:
+            print("ошибка:", error)
+    finally:
+        os.remove(path)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--threads", type=int, default=8, help="Одновременно оформляющих покупателей")
+    parser.add_argument("--orders", type=int, default=400, help="Всего заказов")
+    parser.add_argument("--items", type=int, default=50, help="Товаров в корзине")
+    args = parser.parse_args()
+    run(args.threads, args.orders, args.items)
@@ -1,22 +1,38 @@
 from config.config_server import get_config
 from routers import router
-from database import create_table
+from database import create_table, create_session
+from crud import backfill_image_hashes, backfill_order_totals
+from metrics import MetricsMiddleware
 
 
 import uvicorn
 import argparse
+import logging
 from fastapi import FastAPI
+from fastapi.middleware.gzip import GZipMiddleware
 
 
 def main(config_file_path):
     config = get_config(config_file_path)
     host = config["server"]["host"]
     port = int(config["server"]["port"])
+    # DEBUG включает выборочный вывод SQL запросов каталога
+    logging.basicConfig(level=config.get("logging", "level", fallback="INFO"))
 
     print(f"Создано приложение FastAPI по адресу: {host}:{port}")
     create_table()
+    db = create_session()
+    try:
+        backfill_image_hashes(db)
+        backfill_order_totals(db)
+    finally:
+        db.close()
 
     app = FastAPI()
+    # Каталог и заказы - большие JSON, сжимаются в несколько раз; мелкие ответы отдаются как есть
+    app.add_middleware(GZipMiddleware, minimum_size=1024)
+    # Подключается последней, поэтому внешняя: время включает сжатие, а размер ответа - уже сжатый
+    app.add_middleware(MetricsMiddleware)
     app.include_router(router)
 
     uvicorn.run(app, host=host, port=port)
@@ -1,16 +1,26 @@
-from typing import Optional
+from typing import List, Optional, Tuple
 
 from fastapi import HTTPException
 
-from sqlalchemy.orm import Session, joinedload
+from sqlalchemy import case, delete, func, insert, select, text, update
+from sqlalchemy.orm import Session, joinedload, defer
 import models # ДЛЯ ПРОГРАММЫ
 import schemas # ДЛЯ ПРОГРАММЫ
+from pagination import encode_cursor, decode_cursor, keyset_filter
+from discounts import DiscountTier, discount_cache
 
 # ДЛЯ ТЕСТОВ:
 # from . import models
 # from . import schemas
 
 from datetime import datetime
+import base64
+import binascii
+import logging
+import random
+import re
+
+logger = logging.getLogger(__name__)
 
 def get_customer_by_email(db: Session, email: str):
     return db.query(models.Customer).filter(models.Customer.Email == email).first()
@@ -64,86 +74,92 @@ def get_or_create_cart(db: Session, customer_id: int) -> models.Cart:
         db.refresh(cart)
     return cart
 
-def calculate_discount(db: Session, total_items: int, total_price: float) -> Optional[models.Discount]:
-    if total_items == 0 or total_price == 0.0:
-        return None
+def calculate_discount(db: Session, total_items: int, total_price: float) -> Optional[DiscountTier]:
+    # Ступени берутся из индекса в памяти, запрос к Discounts нужен только после их изменения
+    return discount_cache.get(db).find(total_items, total_price)
 
-    return (
-        db.query(models.Discount)
-        .filter(
-            models.Discount.MinQuantity <= total_items,
-            models.Discount.MaxQuantity >= total_items,
-            models.Discount.MinTotalPrice <= total_price
-        )
-        .order_by(models.Discount.DiscountRate.desc())
-        .first()
-    )
 
+def get_discounts(db: Session) -> Tuple[str, schemas.DiscountsList]:
+    # Клиент по этой таблице сам считает скидку корзины так же, как calculate_discount.
+    # Версия меняется вместе с содержимым таблицы и служит ETag ответа
+    index = discount_cache.get(db)
+    return index.version, schemas.DiscountsList(discounts=index.tiers)
 
-def get_cart_items(db: Session, customer_id: int) -> schemas.CartItemsList:
-    customer = db.query(models.Customer).filter(
-        models.Customer.CustomerID == customer_id
-    ).first()
-    if not customer:
-        raise HTTPException(status_code=404, detail="Customer not found")
 
-    cart = (
-        db.query(models.Cart)
-        .filter(models.Cart.CustomerID == customer_id)
+def select_cart_rows(customer_id: int):
+    # Покупатель, его последняя корзина и её товары вместе с ценами одним запросом по индексам
+    # Carts(CustomerID, LastUpdated) и CartItems(CartID, ProductID). Нет строк - нет покупателя;
+    # CartID = NULL - нет корзины; пустая корзина даёт одну строку без товара
+    latest_cart = (
+        select(models.Cart.CartID)
+        .where(models.Cart.CustomerID == models.Customer.CustomerID)
         .order_by(models.Cart.LastUpdated.desc().nullslast(), models.Cart.CreatedDate.desc())
-        .first()
+        .limit(1)
+        .correlate(models.Customer)
+        .scalar_subquery()
     )
-    if not cart:
-        raise HTTPException(status_code=404, detail="No cart found for this customer")
-
-    items_query = (
-        db.query(
-            models.CartItem,
-            models.Product.Name.label("ProductName"),
-            models.Product.RetailPrice.label("Price"),
-            models.Product.WholesalePrice.label("WholesalePrice")
+    return (
+        select(
+            models.Cart.CartID,
+            models.CartItem.CartItemID,
+            models.CartItem.ProductID,
+            models.CartItem.Quantity,
+            models.CartItem.AddedDate,
+            models.Product.Name,
+            models.Product.RetailPrice,
+            models.Product.WholesalePrice,
         )
-        .join(models.Product, models.Product.ProductID == models.CartItem.ProductID)
-        .filter(models.CartItem.CartID == cart.CartID)
-        .all()
+        .select_from(models.Customer)
+        .outerjoin(models.Cart, models.Cart.CartID == latest_cart)
+        .outerjoin(models.CartItem, models.CartItem.CartID == models.Cart.CartID)
+        .outerjoin(models.Product, models.Product.ProductID == models.CartItem.ProductID)
+        .where(models.Customer.CustomerID == customer_id)
     )
 
+
+def get_cart_items(db: Session, customer_id: int) -> dict:
+    # Корзину читают чаще всего: один запрос, и ответ собирается сразу в виде CartItemsList
+    # по алиасам, без промежуточных объектов Pydantic
+    rows = db.execute(select_cart_rows(customer_id)).all()
+
+    if not rows:
+        raise HTTPException(status_code=404, detail="Customer not found")
+    cart_id = rows[0].CartID
+    if cart_id is None:
+        raise HTTPException(status_code=404, detail="No cart found for this customer")
+
     cart_items = []
     total_items = 0
     total_price = 0.0
-    wholesale_total = 0.0
-
-    for cart_item, product_name, price, wholesale_price in items_query:
-        quantity = cart_item.Quantity
-        total_items += quantity
-        total_price += quantity * price
-        wholesale_total += quantity * wholesale_price
-
-        cart_items.append(
-            schemas.CartItem(
-                id=cart_item.CartItemID,
-                product_id=cart_item.ProductID,
-                quantity=quantity,
-                product_name=product_name,
-                price=price,
-                added_date=cart_item.AddedDate
-            )
-        )
+
+    for row in rows:
+        # Пустая корзина даёт одну строку без товара; позиции с удалённым товаром не показываются
+        if row.Name is None:
+            continue
+        total_items += row.Quantity
+        total_price += row.Quantity * row.RetailPrice
+        cart_items.append({
+            "ProductID": row.ProductID,
+            "Quantity": row.Quantity,
+            "CartItemID": row.CartItemID,
+            "ProductName": row.Name,
+            "Price": row.RetailPrice,
+            "AddedDate": row.AddedDate.isoformat(),
+        })
 
     discount = calculate_discount(db, total_items, total_price)
     discount_rate = discount.DiscountRate if discount else 0.0
-    discounted_price = round(total_price * (1 - discount_rate), 2)
-
-    return schemas.CartItemsList(
-        items=cart_items,
-        total_items=total_items,
-        total_price=round(total_price, 2),
-        discounted_price=discounted_price,
-        discount_rate=discount_rate,
-        discount_id=discount.DiscountID if discount else None,
-        cart_id=cart.CartID,
-        customer_id=cart.CustomerID
-    )
+
+    return {
+        "items": cart_items,
+        "total_items": total_items,
+        "total_price": round(total_price, 2),
+        "discounted_price": round(total_price * (1 - discount_rate), 2),
+        "discount_rate": discount_rate,
+        "discount_id": discount.DiscountID if discount else None,
+        "CartID": cart_id,
+        "CustomerID": customer_id,
+    }
 
 def add_to_cart(db: Session, customer_id: int, item: schemas.CartItemCreate) -> schemas.CartItem:
     product = db.query(models.Product).filter(models.Product.ProductID == item.product_id).first()
@@ -184,6 +200,54 @@ def add_to_cart(db: Session, customer_id: int, item: schemas.CartItemCreate) ->
     })
 
 
+def apply_cart_operations(db: Session, customer_id: int, operations: List[schemas.CartOperation]) -> dict:
+    # Пакет изменений корзины одной транзакцией: товары и строки корзины читаются
+    # двумя запросами на весь пакет, а не по запросу на каждую операцию
+    if not db.query(models.Customer.CustomerID).filter(models.Customer.CustomerID == customer_id).first():
+        raise HTTPException(status_code=404, detail="Customer not found")
+
+    deltas = {}
+    for operation in operations:
+        deltas[operation.product_id] = deltas.get(operation.product_id, 0) + operation.quantity
+
+    known = {
+        product_id for (product_id,) in
+        db.query(models.Product.ProductID).filter(models.Product.ProductID.in_(deltas)).all()
+    }
+    missing = sorted(set(deltas) - known)
+    if missing:
+        raise HTTPException(status_code=404, detail=f"Product not found: {missing}")
+
+    cart = get_or_create_cart(db, customer_id)
+    items = {
+        item.ProductID: item for item in
+        db.query(models.CartItem).filter(
+            models.CartItem.CartID == cart.CartID,
+            models.CartItem.ProductID.in_(deltas)
+        ).all()
+    }
+
+    for product_id, delta in deltas.items():
+        item = items.get(product_id)
+        quantity = (item.Quantity if item else 0) + delta
+        if quantity <= 0:
+            if item:
+                db.delete(item)
+        elif item:
+            item.Quantity = quantity
+        else:
+            db.add(models.CartItem(CartID=cart.CartID, ProductID=product_id, Quantity=quantity))
+    cart.LastUpdated = datetime.utcnow()
+
+    try:
+        db.commit()
+    except Exception as e:
+        db.rollback()
+        raise HTTPException(status_code=400, detail=str(e))
+
+    return get_cart_items(db, customer_id)
+
+
 def update_cart_item(db: Session, item_id: int, item_update: schemas.CartItemUpdate) -> schemas.CartItem:
     db_item = db.query(models.CartItem).filter(models.CartItem.CartItemID == item_id).first()
     if not db_item:
@@ -202,6 +266,14 @@ def update_cart_item(db: Session, item_id: int, item_update: schemas.CartItemUpd
 
     return schemas.CartItem.model_validate(item_data)
 
+def get_cart_item_customer_id(db: Session, item_id: int) -> Optional[int]:
+    return (
+        db.query(models.Cart.CustomerID)
+        .join(models.CartItem, models.CartItem.CartID == models.Cart.CartID)
+        .filter(models.CartItem.CartItemID == item_id)
+        .scalar()
+    )
+
 def remove_from_cart(db: Session, item_id: int) -> bool:
     db_item = db.query(models.CartItem).filter(models.CartItem.CartItemID == item_id).first()
     if not db_item:
@@ -218,70 +290,116 @@ def clear_cart(db: Session, customer_id: int) -> bool:
     return True
 
 def create_order(db: Session, customer_id: int, order_data: schemas.TransactionCreate) -> schemas.TransactionResponse:
+    # Пока идёт запись, SQLite держит блокировку на всю базу, поэтому число обращений внутри
+    # транзакции не зависит от размера заказа: корзина с ценами читается одним запросом,
+    # строки заказа вставляются одним INSERT ... RETURNING, фиксация - одна
     try:
         with db.begin():
-            customer = db.query(models.Customer).get(customer_id)
-            if not customer:
+            rows = db.execute(select_cart_rows(customer_id)).all()
+            if not rows:
                 raise ValueError("Customer not found")
-            cart = db.query(models.Cart).filter_by(CustomerID=customer_id).first()
-            if not cart:
+            cart_id = rows[0].CartID
+            if cart_id is None:
                 raise ValueError("Cart not found")
-            cart_items = db.query(models.CartItem).filter_by(CartID=cart.CartID).all()
-            if not cart_items:
+            items = [row for row in rows if row.Name is not None]
+            if not items:
                 raise ValueError("Cart is empty")
-            total_quantity = sum(item.Quantity for item in cart_items)
-            total_price = sum(
-                item.Quantity * (item.product.WholesalePrice if order_data.is_wholesale else item.product.RetailPrice)
-                for item in cart_items
-            )
+
+            prices = [row.WholesalePrice if order_data.is_wholesale else row.RetailPrice for row in items]
+            total_quantity = sum(row.Quantity for row in items)
+            total_price = sum(row.Quantity * price for row, price in zip(items, prices))
             discount = calculate_discount(db, total_quantity, total_price)
             discount_rate = discount.DiscountRate if discount else 0.0
-            db_transaction = models.Transaction(
-                CustomerID=customer_id,
-                EmployeeID=order_data.employee_id,
-                IsWholesale=order_data.is_wholesale,
-                TransactionDate=datetime.utcnow()
-            )
-            db.add(db_transaction)
-            db.flush()
-            details_response = []
-            final_total = 0.0
-            for item in cart_items:
-                product = item.product
-                price = product.WholesalePrice if order_data.is_wholesale else product.RetailPrice
-                item_total = price * item.Quantity * (1 - discount_rate)
-                db_detail = models.TransactionDetail(TransactionID=db_transaction.TransactionID, ProductID=item.ProductID, Quantity=item.Quantity, Discount=discount_rate)
-                db.add(db_detail)
-                db.flush()
-                details_response.append(schemas.TransactionDetailResponse(
-                    id=db_detail.TransactionDetailID,
-                    transaction_id=db_transaction.TransactionID,
-                    product_id=item.ProductID,
-                    quantity=item.Quantity,
-                    discount=discount_rate,
-                    product_name=product.Name,
-                    current_price=price,
-                    calculated_total=item_total
-                ))
-                final_total += item_total
-            db.query(models.CartItem).filter_by(CartID=cart.CartID).delete()
-            return schemas.TransactionResponse(
-                id=db_transaction.TransactionID,
-                customer_id=db_transaction.CustomerID,
-                employee_id=db_transaction.EmployeeID,
-                is_wholesale=db_transaction.IsWholesale,
-                transaction_date=db_transaction.TransactionDate,
-                total_amount=final_total,
-                discount_amount=total_price * discount_rate,
-                details=details_response
-            )
+            totals = [price * row.Quantity * (1 - discount_rate) for row, price in zip(items, prices)]
+            final_total = sum(totals)
+            discount_amount = total_price * discount_rate
+
+            transaction_date = datetime.utcnow()
+            transaction_id = db.execute(
+                insert(models.Transaction)
+                .values(CustomerID=customer_id, EmployeeID=order_data.employee_id,
+                        IsWholesale=order_data.is_wholesale, TransactionDate=transaction_date,
+                        ItemCount=len(items), TotalQuantity=total_quantity,
+                        TotalAmount=final_total, DiscountAmount=discount_amount)
+                .returning(models.Transaction.TransactionID)
+            ).scalar_one()
+            # SQLite не гарантирует порядок строк RETURNING (а с sort_by_parameter_order SQLAlchemy
+            # вставляет по строке), поэтому номера сопоставляются со строками корзины по товару и количеству
+            inserted = db.execute(
+                insert(models.TransactionDetail).returning(
+                    models.TransactionDetail.TransactionDetailID,
+                    models.TransactionDetail.ProductID,
+                    models.TransactionDetail.Quantity,
+                ),
+                [
+                    {"TransactionID": transaction_id, "ProductID": row.ProductID,
+                     "Quantity": row.Quantity, "Discount": discount_rate, "UnitPrice": price}
+                    for row, price in zip(items, prices)
+                ],
+            ).all()
+            detail_ids = {}
+            for detail_id, product_id, quantity in inserted:
+                detail_ids.setdefault((product_id, quantity), []).append(detail_id)
+            db.execute(delete(models.CartItem).where(models.CartItem.CartID == cart_id))
+
+        details_response = []
+        for row, price, item_total in zip(items, prices, totals):
+            details_response.append(schemas.TransactionDetailResponse(
+                id=detail_ids[(row.ProductID, row.Quantity)].pop(),
+                transaction_id=transaction_id,
+                product_id=row.ProductID,
+                quantity=row.Quantity,
+                discount=discount_rate,
+                product_name=row.Name,
+                current_price=price,
+                calculated_total=item_total
+            ))
+        return schemas.TransactionResponse(
+            id=transaction_id,
+            customer_id=customer_id,
+            employee_id=order_data.employee_id,
+            is_wholesale=order_data.is_wholesale,
+            transaction_date=transaction_date,
+            total_amount=final_total,
+            discount_amount=discount_amount,
+            details=details_response
+        )
     except Exception as e:
         db.rollback()
         raise ValueError(f"Order creation failed: {str(e)}")
 
 
 
+def order_detail_response(detail: models.TransactionDetail, product: models.Product):
+    # Цена и итоги - сохранённые при оформлении, а не текущие цены каталога
+    price = detail.UnitPrice
+    return schemas.TransactionDetailResponse(
+        id=detail.TransactionDetailID,
+        transaction_id=detail.TransactionID,
+        product_id=detail.ProductID,
+        quantity=detail.Quantity,
+        discount=detail.Discount,
+        product_name=product.Name,
+        current_price=price,
+        calculated_total=detail.Quantity * price * (1 - (detail.Discount or 0))
+    )
+
+
+def order_response(order: models.Transaction, details: List[schemas.TransactionDetailResponse]) -> schemas.TransactionResponse:
+    return schemas.TransactionResponse(
+        id=order.TransactionID,
+        customer_id=order.CustomerID,
+        employee_id=order.EmployeeID,
+        is_wholesale=order.IsWholesale,
+        transaction_date=order.TransactionDate,
+        total_amount=order.TotalAmount,
+        discount_amount=order.DiscountAmount,
+        details=details
+    )
+
+
 def get_orders(db: Session, customer_id: int) -> schemas.TransactionsList:
+    # Полная история со строками одним ответом; клиент листает её через get_orders_page
     orders = db.query(models.Transaction) \
         .options(joinedload(models.Transaction.details)
                  .joinedload(models.TransactionDetail.product)) \
@@ -289,101 +407,96 @@ def get_orders(db: Session, customer_id: int) -> schemas.TransactionsList:
         .order_by(models.Transaction.TransactionDate.desc()) \
         .all()
 
-    transactions = []
-    for order in orders:
-        total = sum(
-            detail.Quantity * (
-                detail.product.WholesalePrice if order.IsWholesale
-                else detail.product.RetailPrice
-            ) * (1 - (detail.Discount or 0))
-            for detail in order.details
-        )
-
-        transactions.append(schemas.TransactionResponse(
-            id=order.TransactionID,
-            customer_id=order.CustomerID,
-            employee_id=order.EmployeeID,
-            is_wholesale=order.IsWholesale,
-            transaction_date=order.TransactionDate,
-            total_amount=total,
-            discount_amount=sum(
-                detail.Quantity * (
-                    detail.product.WholesalePrice if order.IsWholesale
-                    else detail.product.RetailPrice
-                ) * (detail.Discount or 0)
-                for detail in order.details
-            ),
-            details=[
-                schemas.TransactionDetailResponse(
-                    id=detail.TransactionDetailID,
-                    transaction_id=detail.TransactionID,
-                    product_id=detail.ProductID,
-                    quantity=detail.Quantity,
-                    discount=detail.Discount,
-                    product_name=detail.product.Name,
-                    current_price=(
-                        detail.product.WholesalePrice if order.IsWholesale
-                        else detail.product.RetailPrice
-                    ),
-                    calculated_total=(
-                            detail.Quantity * (
-                        detail.product.WholesalePrice if order.IsWholesale
-                        else detail.product.RetailPrice
-                    ) * (1 - (detail.Discount or 0))
-                    )
-                )
-                for detail in order.details
-            ]
-        ))
-
-    return schemas.TransactionsList(transactions=transactions)
+    return schemas.TransactionsList(transactions=[
+        order_response(order, [order_detail_response(detail, detail.product) for detail in order.details])
+        for order in orders
+    ])
+
+
+ORDERS_PAGE_KEYS = (models.Transaction.TransactionDate, models.Transaction.TransactionID)
+
+
+def get_orders_page(db: Session, customer_id: int, limit: int, before: Optional[str] = None) -> schemas.OrdersPage:
+    # Итоги хранятся в самих заказах, поэтому страница - один проход по индексу
+    # (CustomerID, TransactionDate, TransactionID) от новых заказов к старым, без строк и товаров
+    query = select(
+        models.Transaction.TransactionID,
+        models.Transaction.EmployeeID,
+        models.Transaction.IsWholesale,
+        models.Transaction.TransactionDate,
+        models.Transaction.ItemCount,
+        models.Transaction.TotalQuantity,
+        models.Transaction.TotalAmount,
+        models.Transaction.DiscountAmount,
+    ).where(models.Transaction.CustomerID == customer_id)
+    if before:
+        date_text, transaction_id = decode_cursor(before, len(ORDERS_PAGE_KEYS))
+        try:
+            cursor_values = [datetime.fromisoformat(date_text), int(transaction_id)]
+        except (TypeError, ValueError):
+            raise ValueError("Invalid cursor")
+        query = query.where(keyset_filter(ORDERS_PAGE_KEYS, cursor_values, True))
+    rows = db.execute(query.order_by(*(key.desc() for key in ORDERS_PAGE_KEYS)).limit(limit + 1)).all()
+
+    next_cursor = None
+    if len(rows) > limit:
+        rows = rows[:limit]
+        last = rows[-1]
+        next_cursor = encode_cursor([last.TransactionDate.isoformat(), last.TransactionID])
+
+    return schemas.OrdersPage(
+        orders=[
+            schemas.OrderSummary(
+                id=row.TransactionID,
+                employee_id=row.EmployeeID,
+                is_wholesale=row.IsWholesale,
+                transaction_date=row.TransactionDate,
+                item_count=row.ItemCount,
+                total_quantity=row.TotalQuantity,
+                total_amount=row.TotalAmount,
+                discount_amount=row.DiscountAmount,
+            )
+            for row in rows
+        ],
+        next_cursor=next_cursor
+    )
 
 
-def get_order_details(db: Session, order_id: int) -> schemas.TransactionResponse:
+def get_order_details(db: Session, order_id: int) -> Optional[schemas.TransactionResponse]:
     order = db.query(models.Transaction).get(order_id)
     if not order:
         return None
 
-    details = db.query(models.TransactionDetail).filter(
-        models.TransactionDetail.TransactionID == order_id
-    ).all()
+    rows = (
+        db.query(models.TransactionDetail, models.Product)
+        .join(models.Product, models.Product.ProductID == models.TransactionDetail.ProductID)
+        .filter(models.TransactionDetail.TransactionID == order_id)
+        .order_by(models.TransactionDetail.TransactionDetailID)
+        .all()
+    )
+    return order_response(order, [order_detail_response(detail, product) for detail, product in rows])
 
-    order_dict ={
-        "TransactionID": order.TransactionID,
-        "CustomerID": order.CustomerID,
-        "EmployeeID": order.EmployeeID,
-        "IsWholesale": order.IsWholesale,
-        "TransactionDate": order.TransactionDate
-    }
+# Доля запросов каталога, чей SQL попадает в журнал на уровне DEBUG. Текст запроса
+# собирается только для попавших в выборку, остальные запросы этим не нагружаются
+SQL_LOG_SAMPLE_RATE = 0.01
 
-    details_list = []
-    for detail in details:
-        details_list.append({
-            "TransactionDetailID": detail.TransactionDetailID,
-            "ProductID": detail.ProductID,
-            "Quantity": detail.Quantity,
-            "Discount": detail.Discount
-        })
 
-    total_amount = sum(
-        detail.Quantity * (detail.product.WholesalePrice if order.IsWholesale else detail.product.RetailPrice)
-        for detail in details
-    )
+def log_query(query):
+    if logger.isEnabledFor(logging.DEBUG) and random.random() < SQL_LOG_SAMPLE_RATE:
+        logger.debug("SQL Query: %s", query.statement.compile(compile_kwargs={"literal_binds": True}))
 
-    return schemas.TransactionDetails(
-        **order_dict,
-        details=details_list,
-        total_amount=total_amount
-    )
 
 def get_products(
     db: Session,
     price_lt: float = None,
     price_gt: float = None,
     name: str = None,
-    sort_by: str = None
+    sort_by: str = None,
+    limit: int = None,
+    after: str = None
 ) -> schemas.ProductsList:
-    query = db.query(models.Product)
+    # Картинки в список не попадают: клиент скачивает их отдельно и кэширует по ImageHash
+    query = db.query(models.Product).options(defer(models.Product.Image))
 
     if price_lt is not None:
         query = query.filter(models.Product.RetailPrice < price_lt)
@@ -392,49 +505,221 @@ def get_products(
     if name:
         query = query.filter(models.Product.Name.ilike(f"%{name}%"))
 
-    sort_options = {
-        "retail_price_asc": models.Product.RetailPrice.asc(),
-        "retail_price_desc": models.Product.RetailPrice.desc(),
-        "wholesale_price_asc": models.Product.WholesalePrice.asc(),
-        "wholesale_price_desc": models.Product.WholesalePrice.desc(),
-        "name_asc": models.Product.Name.asc(),
-        "name_desc": models.Product.Name.desc(),
-        "description_asc": models.Product.Description.asc(),
-        "description_desc": models.Product.Description.desc(),
-        "id_asc": models.Product.ProductID.asc(),
-        "id_desc": models.Product.ProductID.desc()
+    sort_columns = {
+        "retail_price": models.Product.RetailPrice,
+        "wholesale_price": models.Product.WholesalePrice,
+        "name": models.Product.Name,
+        "description": func.coalesce(models.Product.Description, ""),
+        "id": models.Product.ProductID
     }
-    if sort_by in sort_options:
-        query = query.order_by(sort_options[sort_by])
+    sort_field, _, direction = (sort_by or "").rpartition("_")
+    if sort_field not in sort_columns or direction not in ("asc", "desc"):
+        sort_field, direction = ("id", "asc") if limit is not None else (None, None)
+
+    if sort_field is None:
+        log_query(query)
+        return schemas.ProductsList(products=query.all())
+
+    # Keyset-пагинация: ProductID добавляется вторым ключом, чтобы порядок был строгим при равных значениях
+    descending = direction == "desc"
+    keys = [sort_columns[sort_field]]
+    if sort_field != "id":
+        keys.append(models.Product.ProductID)
+    query = query.order_by(*(key.desc() if descending else key.asc() for key in keys))
+
+    if after:
+        query = query.filter(keyset_filter(keys, decode_cursor(after, len(keys)), descending))
+
+    log_query(query)
+
+    if limit is None:
+        return schemas.ProductsList(products=query.all())
+
+    # Запрашиваем на одну строку больше, чтобы без COUNT(*) узнать, есть ли следующая страница
+    products = query.limit(limit + 1).all()
+    next_cursor = None
+    if len(products) > limit:
+        products = products[:limit]
+        last = products[-1]
+        last_values = {
+            "retail_price": last.RetailPrice,
+            "wholesale_price": last.WholesalePrice,
+            "name": last.Name,
+            "description": last.Description or "",
+            "id": last.ProductID
+        }
+        next_cursor = encode_cursor([last_values[sort_field]] + ([last.ProductID] if sort_field != "id" else []))
+
+    return schemas.ProductsList(products=products, next_cursor=next_cursor)
+
+def search_match_expression(query: str) -> Optional[str]:
+    # Каждое слово запроса ищется как префикс; слова экранируются кавычками,
+    # чтобы операторы FTS5 (OR, NEAR, *, :) из пользовательского ввода не интерпретировались
+    words = re.findall(r"\w+", query)
+    if not words:
+        return None
+    return " ".join(f'"{word}"*' for word in words)
 
-    print("SQL Query:", str(query.statement.compile(compile_kwargs={"literal_binds": True})))
 
-    products = query.all()
-    return schemas.ProductsList(products=products)
+def search_products(db: Session, query: str, limit: int = 100) -> schemas.ProductsList:
+    product_ids = []
 
-def search_products(db: Session, query: str) -> schemas.ProductsList:
+    # Числовой запрос может быть номером товара или ценой - такие совпадения идут первыми
     try:
-        query_num = float(query)
-        products = db.query(models.Product).filter(
-            (models.Product.ProductID == int(query_num)) |
+        query_num = float(query.replace(",", "."))
+        exact = db.query(models.Product.ProductID).filter(
+            (models.Product.ProductID == query_num) |
             (models.Product.WholesalePrice == query_num) |
-            (models.Product.RetailPrice == query_num) |
-            (models.Product.Name.ilike(f"%{query}%")) |
-            (models.Product.Description.ilike(f"%{query}%"))
-        ).all()
+            (models.Product.RetailPrice == query_num)
+        ).order_by(models.Product.ProductID).limit(limit).all()
+        product_ids.extend(row.ProductID for row in exact)
     except ValueError:
-        products = db.query(models.Product).filter(
-            (models.Product.Name.ilike(f"%{query}%")) |
-            (models.Product.Description.ilike(f"%{query}%"))
-        ).all()
+        pass
+
+    match = search_match_expression(query)
+    if match and len(product_ids) < limit:
+        if db.get_bind().dialect.name == "sqlite":
+            # bm25: чем меньше значение, тем выше релевантность; совпадение в названии весит больше описания.
+            # Ранжируются все совпадения: для ORDER BY ... LIMIT FTS5 держит только первые limit строк
+            rows = db.execute(
+                text(
+                    "SELECT rowid FROM ProductsFTS WHERE ProductsFTS MATCH :match "
+                    "ORDER BY bm25(ProductsFTS, 10.0, 1.0) LIMIT :limit"
+                ),
+                {"match": match, "limit": limit}
+            ).all()
+            found = [row[0] for row in rows]
+        else:
+            found = [row.ProductID for row in db.query(models.Product.ProductID).filter(
+                (models.Product.Name.ilike(f"%{query}%")) |
+                (models.Product.Description.ilike(f"%{query}%"))
+            ).limit(limit).all()]
+        product_ids.extend(product_id for product_id in found if product_id not in product_ids)
+
+    product_ids = product_ids[:limit]
+    if not product_ids:
+        return schemas.ProductsList(products=[])
+
+    products = db.query(models.Product).options(defer(models.Product.Image)).filter(
+        models.Product.ProductID.in_(product_ids)
+    ).all()
+    by_id = {product.ProductID: product for product in products}
+    return schemas.ProductsList(products=[by_id[product_id] for product_id in product_ids if product_id in by_id])
+
+
+def get_catalog_version(db: Session) -> str:
+    # Число товаров добавлено к ревизии на случай пересоздания базы: ревизия тогда начинается заново
+    revision = db.query(models.CatalogState.Revision).filter(models.CatalogState.StateID == 1).scalar() or 0
+    count = db.query(func.count(models.Product.ProductID)).scalar()
+    return f"{revision}-{count}"
+
 
-    return schemas.ProductsList(products=products)
+CATALOG_CHANGES_LIMIT = 1000
+
+
+def get_catalog_changes(db: Session, since: str, limit: int = CATALOG_CHANGES_LIMIT) -> schemas.CatalogChanges:
+    # since - версия из /products/version или из предыдущего ответа; значима только ревизия до дефиса
+    revision_text, _, _ = since.partition("-")
+    if not revision_text.isdigit():
+        raise ValueError("Invalid catalog version")
+    since_revision = int(revision_text)
+
+    version = get_catalog_version(db)
+    current_revision = int(version.partition("-")[0])
+    if db.get_bind().dialect.name != "sqlite" or since_revision > current_revision:
+        return schemas.CatalogChanges(version=version, reset=True)
+
+    products = (
+        db.query(models.Product)
+        .options(defer(models.Product.Image))
+        .filter(models.Product.ChangeVersion > since_revision)
+        .order_by(models.Product.ChangeVersion)
+        .limit(limit + 1)
+        .all()
+    )
+    tombstones = (
+        db.query(models.ProductTombstone)
+        .filter(models.ProductTombstone.ChangeVersion > since_revision)
+        .order_by(models.ProductTombstone.ChangeVersion)
+        .limit(limit + 1)
+        .all()
+    )
+
+    # Номера ревизий уникальны, поэтому граница страницы по ним не разрезает ни одно изменение
+    changes = sorted(products + tombstones, key=lambda change: change.ChangeVersion)
+    has_more = len(changes) > limit
+    if has_more:
+        changes = changes[:limit]
+        version = f"{changes[-1].ChangeVersion}-{version.partition('-')[2]}"
+
+    return schemas.CatalogChanges(
+        version=version,
+        products=[change for change in changes if isinstance(change, models.Product)],
+        deleted=[change.ProductID for change in changes if isinstance(change, models.ProductTombstone)],
+        has_more=has_more
+    )
 
 
 def get_product(db: Session, product_id: int) -> schemas.Product:
-    product = db.query(models.Product).filter(models.Product.ProductID == product_id).first()
+    product = db.query(models.Product).options(defer(models.Product.Image)).filter(models.Product.ProductID == product_id).first()
     if not product:
         return None
     return schemas.Product.model_validate(product)
 
 
+def get_product_image(db: Session, product_id: int):
+    row = db.query(models.Product.Image, models.Product.ImageHash).filter(models.Product.ProductID == product_id).first()
+    if not row or not row.Image:
+        return None
+    try:
+        content = base64.b64decode(row.Image, validate=False)
+    except (ValueError, binascii.Error):
+        content = row.Image.encode("utf-8")
+    return content, row.ImageHash or models.image_hash(row.Image)
+
+
+def backfill_image_hashes(db: Session, batch_size: int = 500):
+    # Для товаров, добавленных до появления колонки ImageHash
+    while True:
+        rows = db.query(models.Product.ProductID, models.Product.Image).filter(
+            models.Product.ImageHash.is_(None),
+            models.Product.Image.isnot(None),
+            models.Product.Image != ""
+        ).limit(batch_size).all()
+        if not rows:
+            break
+        db.bulk_update_mappings(models.Product, [
+            {"ProductID": product_id, "ImageHash": models.image_hash(image)} for product_id, image in rows
+        ])
+        db.commit()
+
+
+def backfill_order_totals(db: Session, batch_size: int = 500):
+    # Заказы, оформленные до появления сохранённых итогов. Цены на момент тех заказов
+    # не сохранились, поэтому берутся текущие - так эти заказы и показывались раньше
+    detail = models.TransactionDetail
+    order = models.Transaction
+    while True:
+        ids = db.execute(select(order.TransactionID).where(order.TotalAmount.is_(None)).limit(batch_size)).scalars().all()
+        if not ids:
+            break
+
+        price = select(case((order.IsWholesale, models.Product.WholesalePrice), else_=models.Product.RetailPrice)) \
+            .where(order.TransactionID == detail.TransactionID, models.Product.ProductID == detail.ProductID) \
+            .scalar_subquery()
+        db.execute(update(detail).where(detail.TransactionID.in_(ids), detail.UnitPrice.is_(None))
+                   .values(UnitPrice=price))
+
+        def aggregate(expression, default):
+            return select(func.coalesce(expression, default)).where(detail.TransactionID == order.TransactionID) \
+                .scalar_subquery()
+
+        gross = detail.Quantity * detail.UnitPrice
+        rate = func.coalesce(detail.Discount, 0)
+        db.execute(update(order).where(order.TransactionID.in_(ids)).values(
+            ItemCount=aggregate(func.count(detail.TransactionDetailID), 0),
+            TotalQuantity=aggregate(func.sum(detail.Quantity), 0),
+            TotalAmount=aggregate(func.sum(gross * (1 - rate)), 0.0),
+            DiscountAmount=aggregate(func.sum(gross * rate), 0.0),
+        ))
+        db.commit()
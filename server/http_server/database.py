@@ -1,4 +1,4 @@
-from sqlalchemy import create_engine
+from sqlalchemy import create_engine, inspect, text
 from sqlalchemy.orm import sessionmaker, Session
 
 from config.config_server import get_config
@@ -15,6 +15,106 @@ SessionLocal = sessionmaker(autocommit=False, autoflush=False, bind=engine)
 
 def create_table():
     Base.metadata.create_all(bind=engine)
+    add_missing_columns()
+    # create_all не трогает существующие таблицы, поэтому индексы, добавленные позже, создаём отдельно
+    for table in Base.metadata.sorted_tables:
+        for index in table.indexes:
+            index.create(bind=engine, checkfirst=True)
+    create_search_index()
+    create_catalog_revision()
+
+
+def add_missing_columns():
+    # Колонки, добавленные в модели после создания базы, дописываются через ALTER TABLE
+    inspector = inspect(engine)
+    with engine.begin() as connection:
+        for table in Base.metadata.sorted_tables:
+            existing = {column["name"] for column in inspector.get_columns(table.name)}
+            for column in table.columns:
+                if column.name not in existing:
+                    column_type = column.type.compile(dialect=engine.dialect)
+                    connection.execute(text(f'ALTER TABLE "{table.name}" ADD COLUMN "{column.name}" {column_type}'))
+
+
+# Полнотекстовый индекс по товарам. Таблица external content: тексты хранятся только в Products,
+# а индекс поддерживается триггерами при любых изменениях Name и Description
+SEARCH_INDEX_TRIGGERS = (
+    """CREATE TRIGGER IF NOT EXISTS ProductsFTS_insert AFTER INSERT ON Products BEGIN
+        INSERT INTO ProductsFTS(rowid, Name, Description) VALUES (new.ProductID, new.Name, new.Description);
+    END""",
+    """CREATE TRIGGER IF NOT EXISTS ProductsFTS_delete AFTER DELETE ON Products BEGIN
+        INSERT INTO ProductsFTS(ProductsFTS, rowid, Name, Description) VALUES ('delete', old.ProductID, old.Name, old.Description);
+    END""",
+    """CREATE TRIGGER IF NOT EXISTS ProductsFTS_update AFTER UPDATE OF Name, Description ON Products BEGIN
+        INSERT INTO ProductsFTS(ProductsFTS, rowid, Name, Description) VALUES ('delete', old.ProductID, old.Name, old.Description);
+        INSERT INTO ProductsFTS(rowid, Name, Description) VALUES (new.ProductID, new.Name, new.Description);
+    END""",
+)
+
+
+def create_search_index():
+    if engine.dialect.name != "sqlite":
+        return
+
+    with engine.begin() as connection:
+        exists = connection.execute(
+            text("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'ProductsFTS'")
+        ).first()
+        if not exists:
+            # unicode61 приводит к нижнему регистру и кириллицу; prefix - готовые индексы для коротких префиксов
+            connection.execute(text(
+                "CREATE VIRTUAL TABLE ProductsFTS USING fts5("
+                "Name, Description, content='Products', content_rowid='ProductID', "
+                "tokenize='unicode61', prefix='2 3')"
+            ))
+        for trigger in SEARCH_INDEX_TRIGGERS:
+            connection.execute(text(trigger))
+        if not exists:
+            # Товары, добавленные до появления индекса
+            connection.execute(text("INSERT INTO ProductsFTS(ProductsFTS) VALUES ('rebuild')"))
+
+
+# Каждое изменение товара получает следующий номер ревизии: он записывается в ChangeVersion
+# строки или, при удалении, в ProductTombstones. Обновление ChangeVersion внутри триггера
+# не должно считаться новым изменением, отсюда условие WHEN у триггера на UPDATE
+CURRENT_REVISION = "(SELECT Revision FROM CatalogState WHERE StateID = 1)"
+CATALOG_REVISION_TRIGGERS = {
+    "Products_revision_insert": f"""AFTER INSERT ON Products BEGIN
+        UPDATE CatalogState SET Revision = Revision + 1 WHERE StateID = 1;
+        UPDATE Products SET ChangeVersion = {CURRENT_REVISION} WHERE ProductID = new.ProductID;
+        DELETE FROM ProductTombstones WHERE ProductID = new.ProductID;
+    END""",
+    "Products_revision_update": f"""AFTER UPDATE ON Products WHEN new.ChangeVersion IS old.ChangeVersion BEGIN
+        UPDATE CatalogState SET Revision = Revision + 1 WHERE StateID = 1;
+        UPDATE Products SET ChangeVersion = {CURRENT_REVISION} WHERE ProductID = new.ProductID;
+    END""",
+    "Products_revision_delete": f"""AFTER DELETE ON Products BEGIN
+        UPDATE CatalogState SET Revision = Revision + 1 WHERE StateID = 1;
+        INSERT OR REPLACE INTO ProductTombstones (ProductID, ChangeVersion) VALUES (old.ProductID, {CURRENT_REVISION});
+    END""",
+}
+
+
+# Ревизия скидок: по ней кэш ступеней в памяти (discounts.py) замечает правки Discounts в обход приложения
+DISCOUNT_REVISION = "UPDATE CatalogState SET DiscountRevision = COALESCE(DiscountRevision, 0) + 1 WHERE StateID = 1;"
+DISCOUNT_REVISION_TRIGGERS = {
+    f"Discounts_revision_{operation.lower()}": f"AFTER {operation} ON Discounts BEGIN {DISCOUNT_REVISION} END"
+    for operation in ("INSERT", "UPDATE", "DELETE")
+}
+
+
+def create_catalog_revision():
+    # Ревизия меняется в той же транзакции, что и товары, поэтому клиент по ней
+    # проверяет актуальность своей копии каталога, не скачивая его
+    with engine.begin() as connection:
+        connection.execute(text("INSERT OR IGNORE INTO CatalogState (StateID, Revision, DiscountRevision) VALUES (1, 0, 0)"))
+        # Товары, появившиеся до колонки ChangeVersion, считаются изменёнными на текущей ревизии
+        connection.execute(text(f"UPDATE Products SET ChangeVersion = {CURRENT_REVISION} WHERE ChangeVersion IS NULL"))
+        if engine.dialect.name == "sqlite":
+            # Триггеры пересоздаются при каждом запуске, чтобы база получала их актуальную версию
+            for name, body in {**CATALOG_REVISION_TRIGGERS, **DISCOUNT_REVISION_TRIGGERS}.items():
+                connection.execute(text(f"DROP TRIGGER IF EXISTS {name}"))
+                connection.execute(text(f"CREATE TRIGGER {name} {body}"))
 
 
 def disconnect_db():
@@ -0,0 +1,127 @@
+import bisect
+import hashlib
+import threading
+import time
+from typing import Iterable, List, NamedTuple, Optional
+
+from sqlalchemy import event
+from sqlalchemy.orm import Session
+
+import models
+
+# Ступени скидок меняются редко, а нужны при каждом чтении корзины и оформлении заказа.
+# Таблица держится в памяти процесса как интервальный индекс и перечитывается, когда
+# приложение меняет Discounts (события сессии) или меняется ревизия скидок в CatalogState
+# (триггеры в базе ловят и правки в обход приложения; ревизия проверяется не чаще раза в несколько секунд).
+
+REVALIDATE_SECONDS = 5.0
+
+
+class DiscountTier(NamedTuple):
+    DiscountID: int
+    MinQuantity: int
+    MaxQuantity: int
+    DiscountRate: float
+    MinTotalPrice: float
+
+
+def better(tier: DiscountTier, current: Optional[DiscountTier]) -> bool:
+    # Как ORDER BY DiscountRate DESC в прежнем запросе; при равной ставке - меньший номер, чтобы выбор был однозначным
+    if current is None:
+        return True
+    return (tier.DiscountRate, -tier.DiscountID) > (current.DiscountRate, -current.DiscountID)
+
+
+class DiscountIndex:
+    def __init__(self, tiers: Iterable[DiscountTier]):
+        self.tiers: List[DiscountTier] = sorted(tiers, key=lambda t: (t.MinQuantity, t.DiscountID))
+        self.version = hashlib.sha1(repr(self.tiers).encode("utf-8")).hexdigest()[:16]
+
+        # Границы интервалов делят ось количества на отрезки с постоянным набором подходящих ступеней.
+        # Для каждого отрезка ступени отсортированы по порогу суммы, и для каждого порога запомнена
+        # лучшая ступень среди уже пройденных. Поиск - два бинарных поиска
+        self.bounds = sorted({t.MinQuantity for t in self.tiers} | {t.MaxQuantity + 1 for t in self.tiers})
+        self.segments = []
+        for start in self.bounds:
+            active = sorted((t for t in self.tiers if t.MinQuantity <= start <= t.MaxQuantity),
+                            key=lambda t: t.MinTotalPrice)
+            prices, best = [], []
+            current = None
+            for tier in active:
+                if better(tier, current):
+                    current = tier
+                prices.append(tier.MinTotalPrice)
+                best.append(current)
+            self.segments.append((prices, best))
+
+    def find(self, total_items: int, total_price: float) -> Optional[DiscountTier]:
+        if total_items == 0 or total_price == 0.0:
+            return None
+
+        segment = bisect.bisect_right(self.bounds, total_items) - 1
+        if segment < 0:
+            return None
+        prices, best = self.segments[segment]
+        position = bisect.bisect_right(prices, total_price) - 1
+        return best[position] if position >= 0 else None
+
+
+def load_tiers(db: Session) -> List[DiscountTier]:
+    rows = db.query(
+        models.Discount.DiscountID,
+        models.Discount.MinQuantity,
+        models.Discount.MaxQuantity,
+        models.Discount.DiscountRate,
+        models.Discount.MinTotalPrice,
+    ).all()
+    return [DiscountTier(*row) for row in rows]
+
+
+def read_revision(db: Session) -> Optional[int]:
+    return db.query(models.CatalogState.DiscountRevision).filter(models.CatalogState.StateID == 1).scalar()
+
+
+class DiscountCache:
+    def __init__(self, revalidate_seconds: float = REVALIDATE_SECONDS):
+        self.revalidate_seconds = revalidate_seconds
+        self._lock = threading.Lock()
+        self._index: Optional[DiscountIndex] = None
+        self._revision: Optional[int] = None
+        self._checked_at = 0.0
+
+    def invalidate(self):
+        with self._lock:
+            self._index = None
+
+    def get(self, db: Session) -> DiscountIndex:
+        index = self._index
+        if index is not None and time.monotonic() - self._checked_at < self.revalidate_seconds:
+            return index
+
+        with self._lock:
+            revision = read_revision(db)
+            if self._index is None or revision != self._revision:
+                self._index = DiscountIndex(load_tiers(db))
+                self._revision = revision
+            self._checked_at = time.monotonic()
+            return self._index
+
+
+discount_cache = DiscountCache()
+
+
+@event.listens_for(Session, "after_flush")
+def track_discount_changes(session: Session, flush_context):
+    if any(isinstance(obj, models.Discount) for obj in (*session.new, *session.dirty, *session.deleted)):
+        session.info["discounts_changed"] = True
+
+
+@event.listens_for(Session, "after_commit")
+def invalidate_discounts(session: Session):
+    if session.info.pop("discounts_changed", False):
+        discount_cache.invalidate()
+
+
+@event.listens_for(Session, "after_rollback")
+def forget_discount_changes(session: Session):
+    session.info.pop("discounts_changed", None)
@@ -0,0 +1,91 @@
+import asyncio
+import contextvars
+import json
+import threading
+from typing import Callable, Dict, Optional, Set
+
+# Рассылка событий клиентам через Server-Sent Events. Обработчики запросов FastAPI
+# выполняются в пуле потоков, а потоки событий живут в цикле asyncio, поэтому сообщения
+# передаются в очереди подписчиков через call_soon_threadsafe.
+
+QUEUE_SIZE = 100
+CATALOG_POLL_SECONDS = 1.0
+
+
+class Subscription:
+    def __init__(self, customer_id: int, loop: asyncio.AbstractEventLoop):
+        self.customer_id = customer_id
+        self.loop = loop
+        self.queue: asyncio.Queue = asyncio.Queue(maxsize=QUEUE_SIZE)
+        # Клиент не успевает читать: вместо потерянных событий он получит resync
+        self.lagging = False
+
+    def offer(self, message: str):
+        # Вызывается только из цикла событий подписчика
+        try:
+            self.queue.put_nowait(message)
+        except asyncio.QueueFull:
+            self.lagging = True
+
+
+def format_event(event: str, data: dict) -> str:
+    return f"event: {event}\ndata: {json.dumps(data, ensure_ascii=False, separators=(',', ':'))}\n\n"
+
+
+class EventBus:
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._subscribers: Dict[int, Set[Subscription]] = {}
+        self._catalog_watcher: Optional[asyncio.Task] = None
+
+    def subscribe(self, customer_id: int) -> Subscription:
+        subscription = Subscription(customer_id, asyncio.get_running_loop())
+        with self._lock:
+            self._subscribers.setdefault(customer_id, set()).add(subscription)
+        return subscription
+
+    def unsubscribe(self, subscription: Subscription):
+        with self._lock:
+            subscriptions = self._subscribers.get(subscription.customer_id)
+            if subscriptions is not None:
+                subscriptions.discard(subscription)
+                if not subscriptions:
+                    del self._subscribers[subscription.customer_id]
+
+    def has_subscribers(self, customer_id: Optional[int] = None) -> bool:
+        with self._lock:
+            if customer_id is None:
+                return bool(self._subscribers)
+            return customer_id in self._subscribers
+
+    def publish(self, event: str, data: dict, customer_id: Optional[int] = None):
+        # customer_id None - событие для всех подключённых клиентов. Можно вызывать из любого потока
+        message = format_event(event, data)
+        with self._lock:
+            if customer_id is None:
+                targets = [s for subscriptions in self._subscribers.values() for s in subscriptions]
+            else:
+                targets = list(self._subscribers.get(customer_id, ()))
+        for subscription in targets:
+            subscription.loop.call_soon_threadsafe(subscription.offer, message)
+
+    def watch_catalog(self, read_version: Callable[[], str]):
+        # Один опрос ревизии на весь сервер вместо опроса каталога каждым клиентом.
+        # Изменения в базу могут вносить и в обход API, поэтому следим за ревизией, а не за запросами
+        if self._catalog_watcher is None or self._catalog_watcher.done():
+            # Задача запускается в пустом контексте: опрос общий для сервера и не должен
+            # числиться в метриках за запросом, который его запустил
+            loop = asyncio.get_running_loop()
+            self._catalog_watcher = contextvars.Context().run(loop.create_task, self._watch_catalog(read_version))
+
+    async def _watch_catalog(self, read_version: Callable[[], str]):
+        version = await asyncio.to_thread(read_version)
+        while self.has_subscribers():
+            await asyncio.sleep(CATALOG_POLL_SECONDS)
+            current = await asyncio.to_thread(read_version)
+            if current != version:
+                version = current
+                self.publish("catalog", {"version": version})
+
+
+event_bus = EventBus()
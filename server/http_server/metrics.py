@@ -0,0 +1,174 @@
+import threading
+import time
+from bisect import bisect_left
+from contextvars import ContextVar
+from typing import Dict, Optional, Sequence, Tuple
+
+from sqlalchemy import event
+from sqlalchemy.engine import Engine
+
+# Метрики сервера в текстовом формате Prometheus (/metrics): время ответа, размеры тел
+# и запросы к базе по маршрутам. Маршрут берётся шаблоном пути ("/customers/{customer_id}/cart"),
+# чтобы число рядов не росло с числом покупателей. Запросы к базе считаются событиями
+# SQLAlchemy и относятся к HTTP-запросу через contextvars: Starlette копирует контекст
+# в поток, где выполняется синхронный обработчик.
+
+LATENCY_BUCKETS = (0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0)
+SIZE_BUCKETS = (128, 512, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304)
+QUERY_COUNT_BUCKETS = (0, 1, 2, 3, 5, 10, 20, 50, 100)
+
+Labels = Tuple[Tuple[str, str], ...]
+
+
+class Histogram:
+    def __init__(self, name: str, description: str, buckets: Sequence[float]):
+        self.name = name
+        self.description = description
+        self.buckets = tuple(buckets)
+        self._lock = threading.Lock()
+        # метки -> [счётчики по корзинам (последняя - +Inf), сумма]
+        self._series: Dict[Labels, list] = {}
+
+    def observe(self, value: float, **labels: str):
+        key = tuple(sorted(labels.items()))
+        position = bisect_left(self.buckets, value)
+        with self._lock:
+            series = self._series.get(key)
+            if series is None:
+                series = self._series[key] = [[0] * (len(self.buckets) + 1), 0.0]
+            series[0][position] += 1
+            series[1] += value
+
+    def render(self) -> str:
+        with self._lock:
+            series = [(key, list(counts), total) for key, (counts, total) in sorted(self._series.items())]
+
+        lines = [f"# HELP {self.name} {self.description}", f"# TYPE {self.name} histogram"]
+        for key, counts, total in series:
+            cumulative = 0
+            for bound, count in zip((*map(format_value, self.buckets), "+Inf"), counts):
+                cumulative += count
+                lines.append(f"{self.name}_bucket{format_labels(key + (('le', bound),))} {cumulative}")
+            lines.append(f"{self.name}_sum{format_labels(key)} {format_value(total)}")
+            lines.append(f"{self.name}_count{format_labels(key)} {cumulative}")
+        return "\n".join(lines) + "\n"
+
+    def reset(self):
+        with self._lock:
+            self._series.clear()
+
+
+def format_value(value: float) -> str:
+    return repr(float(value)) if isinstance(value, float) else str(value)
+
+
+def escape_label(value) -> str:
+    return str(value).replace("\\", "\\\\").replace('"', '\\"').replace("\n", "\\n")
+
+
+def format_labels(labels: Labels) -> str:
+    if not labels:
+        return ""
+    return "{" + ",".join(f'{name}="{escape_label(value)}"' for name, value in labels) + "}"
+
+
+request_duration = Histogram("http_request_duration_seconds", "Время обработки запроса", LATENCY_BUCKETS)
+request_size = Histogram("http_request_size_bytes", "Размер тела запроса", SIZE_BUCKETS)
+response_size = Histogram("http_response_size_bytes", "Размер тела ответа (после сжатия)", SIZE_BUCKETS)
+request_queries = Histogram("http_request_db_queries", "Число запросов к базе на HTTP-запрос", QUERY_COUNT_BUCKETS)
+query_duration = Histogram("db_query_duration_seconds", "Время одного запроса к базе", LATENCY_BUCKETS)
+
+HISTOGRAMS = (request_duration, request_size, response_size, request_queries, query_duration)
+
+CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8"
+
+
+def render() -> str:
+    return "".join(histogram.render() for histogram in HISTOGRAMS)
+
+
+class RequestStats:
+    def __init__(self, scope: dict):
+        self.scope = scope
+        self.queries = 0
+
+    @property
+    def route(self) -> str:
+        # Роутер кладёт найденный маршрут в scope; до сопоставления и для неизвестных путей его нет
+        route = self.scope.get("route")
+        return getattr(route, "path", None) or "unmatched"
+
+
+current_request: ContextVar[Optional[RequestStats]] = ContextVar("current_request", default=None)
+
+
+@event.listens_for(Engine, "before_cursor_execute")
+def start_query_timer(conn, cursor, statement, parameters, context, executemany):
+    conn.info.setdefault("query_started", []).append(time.perf_counter())
+
+
+@event.listens_for(Engine, "after_cursor_execute")
+def record_query(conn, cursor, statement, parameters, context, executemany):
+    started = conn.info["query_started"].pop()
+    stats = current_request.get()
+    if stats is not None:
+        stats.queries += 1
+    # Запросы вне HTTP-запроса - фоновые: слежение за каталогом, заполнение колонок при запуске
+    query_duration.observe(time.perf_counter() - started, route=stats.route if stats else "background")
+
+
+@event.listens_for(Engine, "handle_error")
+def discard_query_timer(context):
+    # after_cursor_execute для упавшего запроса не вызывается
+    started = context.connection.info.get("query_started") if context.connection is not None else None
+    if started:
+        started.pop()
+
+
+class MetricsMiddleware:
+    # ASGI-обёртка, а не BaseHTTPMiddleware: тело ответа не буферизуется, а длинные потоки
+    # событий (/events) проходят насквозь и в гистограммы времени не попадают
+    def __init__(self, app):
+        self.app = app
+
+    async def __call__(self, scope, receive, send):
+        if scope["type"] != "http":
+            await self.app(scope, receive, send)
+            return
+
+        stats = RequestStats(scope)
+        token = current_request.set(stats)
+        started = time.perf_counter()
+        status = 500
+        streaming = False
+        sent_bytes = 0
+        received_bytes = 0
+
+        async def counting_receive():
+            nonlocal received_bytes
+            message = await receive()
+            if message["type"] == "http.request":
+                received_bytes += len(message.get("body", b""))
+            return message
+
+        async def counting_send(message):
+            nonlocal status, streaming, sent_bytes
+            if message["type"] == "http.response.start":
+                status = message["status"]
+                for name, value in message.get("headers", ()):
+                    if name.lower() == b"content-type" and value.startswith(b"text/event-stream"):
+                        streaming = True
+            elif message["type"] == "http.response.body":
+                sent_bytes += len(message.get("body", b""))
+            await send(message)
+
+        try:
+            await self.app(scope, counting_receive, counting_send)
+        finally:
+            current_request.reset(token)
+            if not streaming:
+                labels = {"method": scope["method"], "route": stats.route}
+                request_duration.observe(time.perf_counter() - started, status=str(status), **labels)
+                request_size.observe(received_bytes, **labels)
+                response_size.observe(sent_bytes, **labels)
+                request_queries.observe(stats.queries, **labels)
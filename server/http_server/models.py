@@ -1,6 +1,7 @@
-from sqlalchemy import Column, Integer, String, Date, Float, ForeignKey, Boolean, BLOB, DateTime
+from sqlalchemy import Column, Integer, String, Date, Float, ForeignKey, Boolean, BLOB, DateTime, Index, event
 from sqlalchemy.orm import declarative_base, relationship
 from datetime import datetime
+import hashlib
 
 Base = declarative_base()
 
@@ -40,10 +41,13 @@ class Product(Base):
 
     ProductID = Column(Integer, primary_key=True, autoincrement=True)
     Name = Column(String, nullable=False, index=True)
-    WholesalePrice = Column(Float, nullable=False)
+    WholesalePrice = Column(Float, nullable=False, index=True)
     RetailPrice = Column(Float, nullable=False, index=True)
     Description = Column(String)
     Image = Column(String)
+    ImageHash = Column(String(40))
+    # Ревизия каталога (CatalogState.Revision), на которой товар менялся последний раз; ставится триггером
+    ChangeVersion = Column(Integer, nullable=False, default=0, index=True)
 
     cart_items = relationship("CartItem", back_populates="product")
     transaction_details = relationship("TransactionDetail", back_populates="product")
@@ -52,6 +56,37 @@ class Product(Base):
         return f"<Product(id={self.ProductID}, name='{self.Name}')>"
 
 
+def image_hash(image):
+    if not image:
+        return None
+    return hashlib.sha1(image.encode("utf-8")).hexdigest()
+
+
+@event.listens_for(Product, "before_insert")
+@event.listens_for(Product, "before_update")
+def _update_image_hash(mapper, connection, target):
+    # Хэш меняется только вместе с картинкой, поэтому по нему клиент и HTTP-кэш понимают, что её пора перекачать
+    target.ImageHash = image_hash(target.Image)
+
+
+class CatalogState(Base):
+    # Одна строка с номером ревизии каталога; увеличивается триггерами при любом изменении Products.
+    # DiscountRevision так же отслеживает изменения Discounts
+    __tablename__ = 'CatalogState'
+
+    StateID = Column(Integer, primary_key=True)
+    Revision = Column(Integer, nullable=False, default=0)
+    DiscountRevision = Column(Integer, nullable=False, default=0)
+
+
+class ProductTombstone(Base):
+    # Удалённые товары: по ним клиент с копией каталога узнаёт, какие строки убрать
+    __tablename__ = 'ProductTombstones'
+
+    ProductID = Column(Integer, primary_key=True, autoincrement=False)
+    ChangeVersion = Column(Integer, nullable=False, index=True)
+
+
 class Discount(Base):
     __tablename__ = 'Discounts'
 
@@ -73,11 +108,19 @@ class Transaction(Base):
     CustomerID = Column(Integer, ForeignKey('Customers.CustomerID'), nullable=False)
     EmployeeID = Column(Integer, ForeignKey('Employees.EmployeeID'), nullable=False)
     IsWholesale = Column(Boolean, nullable=False, default=False)
+    # Итоги фиксируются при оформлении заказа и не меняются вместе с ценами товаров
+    ItemCount = Column(Integer)
+    TotalQuantity = Column(Integer)
+    TotalAmount = Column(Float)
+    DiscountAmount = Column(Float)
 
     customer = relationship("Customer", back_populates="transactions")
     employee = relationship("Employee", back_populates="transactions")
     details = relationship("TransactionDetail", back_populates="transaction")
 
+    # История заказов покупателя листается от новых к старым по этому индексу
+    __table_args__ = (Index("ix_Transactions_CustomerID_TransactionDate", "CustomerID", "TransactionDate", "TransactionID"),)
+
     def __repr__(self):
         return f"<Transaction(id={self.TransactionID}, date={self.TransactionDate})>"
 
@@ -86,10 +129,11 @@ class TransactionDetail(Base):
     __tablename__ = 'TransactionDetails'
 
     TransactionDetailID = Column(Integer, primary_key=True, autoincrement=True)
-    TransactionID = Column(Integer, ForeignKey('Transactions.TransactionID'), nullable=False)
+    TransactionID = Column(Integer, ForeignKey('Transactions.TransactionID'), nullable=False, index=True)
     ProductID = Column(Integer, ForeignKey('Products.ProductID'), nullable=False)
     Quantity = Column(Integer, nullable=False, default=1)
     Discount = Column(Float)
+    UnitPrice = Column(Float) # цена товара на момент заказа
 
     transaction = relationship("Transaction", back_populates="details")
     product = relationship("Product", back_populates="transaction_details")
@@ -109,6 +153,9 @@ class Cart(Base):
     customer = relationship("Customer", back_populates="carts")
     items = relationship("CartItem", back_populates="cart", cascade="all, delete-orphan")
 
+    # Последняя корзина покупателя находится по индексу без сортировки таблицы
+    __table_args__ = (Index("ix_Carts_CustomerID_LastUpdated", "CustomerID", "LastUpdated"),)
+
     def __repr__(self):
         return f"<Cart(id={self.CartID}, customer={self.CustomerID})>"
 
@@ -125,5 +172,8 @@ class CartItem(Base):
     cart = relationship("Cart", back_populates="items")
     product = relationship("Product", back_populates="cart_items")
 
+    # Товары корзины и поиск позиции товара при добавлении
+    __table_args__ = (Index("ix_CartItems_CartID_ProductID", "CartID", "ProductID"),)
+
     def __repr__(self):
         return f"<CartItem(id={self.CartItemID}, product={self.ProductID}, qty={self.Quantity})>"
\ No newline at end of file
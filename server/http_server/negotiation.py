@@ -0,0 +1,32 @@
+from fastapi import Request, Response
+from fastapi.responses import JSONResponse
+from pydantic import BaseModel
+
+import cbor
+
+CBOR_MEDIA_TYPE = "application/cbor"
+
+
+def wants_cbor(request: Request) -> bool:
+    return CBOR_MEDIA_TYPE in request.headers.get("accept", "")
+
+
+def negotiated(request: Request, result, model: type[BaseModel]):
+    # По умолчанию ответ остаётся JSON и сериализуется FastAPI по response_model.
+    # Клиент, приславший Accept: application/cbor, получает те же поля (по алиасам) в CBOR
+    if not wants_cbor(request):
+        return result
+
+    if not isinstance(result, model):
+        result = model.model_validate(result)
+    body = cbor.dumps(result.model_dump(mode="json", by_alias=True))
+    # Vary: HTTP-кэш клиента не должен отдать CBOR на JSON-запрос и наоборот
+    return Response(content=body, media_type=CBOR_MEDIA_TYPE, headers={"Vary": "Accept"})
+
+
+def negotiated_payload(request: Request, payload: dict) -> Response:
+    # payload уже в виде ответа (ключи по алиасам, значения JSON-совместимы):
+    # отдаётся без повторной проверки через response_model
+    if wants_cbor(request):
+        return Response(content=cbor.dumps(payload), media_type=CBOR_MEDIA_TYPE, headers={"Vary": "Accept"})
+    return JSONResponse(payload, headers={"Vary": "Accept"})
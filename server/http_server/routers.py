@@ -2,7 +2,14 @@ import crud, schemas
 from database import get_db
 from config.config_server import get_config
 import models
-from fastapi import APIRouter, Depends, HTTPException
+import metrics
+import asyncio
+from database import create_session
+from events import event_bus
+from negotiation import negotiated, negotiated_payload
+from typing import Optional, Union
+from fastapi import APIRouter, Depends, HTTPException, Query, Request, Response
+from fastapi.responses import JSONResponse, StreamingResponse
 from sqlalchemy.orm import Session
 
 CONFIG_FILE_PATH = 'server/http_server/config/config.ini'
@@ -49,9 +56,79 @@ def update_customer(
         raise HTTPException(status_code=404, detail="Customer not found")
     return updated_customer
 
+EVENTS_KEEPALIVE_SECONDS = 15
+# Сколько клиент может не перепроверять ступени скидок; сервер всё равно пересчитывает итог корзины сам
+DISCOUNTS_MAX_AGE_SECONDS = 300
+ORDERS_PAGE_SIZE = 50
+
+
+def publish_cart(db: Session, customer_id: int, cart: Optional[dict] = None):
+    # Открытые окна корзины получают её новое содержимое целиком и не перезапрашивают его.
+    # cart - уже прочитанная корзина, если обработчик запроса её получил
+    if not event_bus.has_subscribers(customer_id):
+        return
+    if cart is None:
+        try:
+            cart = crud.get_cart_items(db, customer_id)
+        except HTTPException:
+            return
+    event_bus.publish("cart", cart, customer_id)
+
+
+def read_catalog_version() -> str:
+    db = create_session()
+    try:
+        return crud.get_catalog_version(db)
+    finally:
+        db.close()
+
+
+@router.get("/customers/{customer_id}/events")
+async def customer_events(customer_id: int, request: Request):
+    # События: cart - новое содержимое корзины, catalog - каталог изменился (клиент забирает
+    # дельту через /products/changes), resync - часть событий потеряна, нужно перечитать всё
+    subscription = event_bus.subscribe(customer_id)
+    event_bus.watch_catalog(read_catalog_version)
+
+    async def stream():
+        try:
+            yield "retry: 3000\n\n"
+            while True:
+                try:
+                    message = await asyncio.wait_for(subscription.queue.get(), EVENTS_KEEPALIVE_SECONDS)
+                except asyncio.TimeoutError:
+                    if await request.is_disconnected():
+                        break
+                    # Комментарий не даёт прокси закрыть простаивающее соединение
+                    yield ": keepalive\n\n"
+                    continue
+                if subscription.lagging:
+                    subscription.lagging = False
+                    yield "event: resync\ndata: {}\n\n"
+                yield message
+        finally:
+            event_bus.unsubscribe(subscription)
+
+    return StreamingResponse(stream(), media_type="text/event-stream",
+                             headers={"Cache-Control": "no-cache", "X-Accel-Buffering": "no"})
+
+@router.get("/discounts", response_model=schemas.DiscountsList)
+def get_discounts(request: Request, response: Response, db: Session = Depends(get_db)):
+    # Ступени меняются редко: клиент держит их в HTTP-кэше и перепроверяет по ETag
+    version, discounts = crud.get_discounts(db)
+    etag = f'"{version}"'
+    headers = {"ETag": etag, "Cache-Control": f"max-age={DISCOUNTS_MAX_AGE_SECONDS}", "Vary": "Accept"}
+    if etag in request.headers.get("if-none-match", ""):
+        return Response(status_code=304, headers=headers)
+
+    result = negotiated(request, discounts, schemas.DiscountsList)
+    target = result if isinstance(result, Response) else response
+    target.headers.update(headers)
+    return result
+
 @router.get("/customers/{customer_id}/cart", response_model=schemas.CartItemsList)
-def get_cart(customer_id: int, db: Session = Depends(get_db)):
-    return crud.get_cart_items(db, customer_id)
+def get_cart(customer_id: int, request: Request, db: Session = Depends(get_db)):
+    return negotiated_payload(request, crud.get_cart_items(db, customer_id))
 
 @router.post("/customers/{customer_id}/cart/items", response_model=schemas.CartItem)
 def add_cart_item(
@@ -60,69 +137,164 @@ def add_cart_item(
     db: Session = Depends(get_db)
 ):
     try:
-        return crud.add_to_cart(db, customer_id, item)
+        result = crud.add_to_cart(db, customer_id, item)
     except Exception as e:
         raise HTTPException(status_code=400, detail=str(e))
+    publish_cart(db, customer_id)
+    return result
+
+@router.post("/customers/{customer_id}/cart/batch", response_model=schemas.CartItemsList)
+def apply_cart_batch(
+    customer_id: int,
+    batch: schemas.CartBatch,
+    request: Request,
+    db: Session = Depends(get_db)
+):
+    cart = crud.apply_cart_operations(db, customer_id, batch.operations)
+    publish_cart(db, customer_id, cart)
+    return negotiated_payload(request, cart)
 
 @router.post("/customers/{customer_id}/orders", response_model=schemas.TransactionResponse)
-def create_order(customer_id: int, order_data: schemas.TransactionCreate, db: Session = Depends(get_db)):
+def create_order(customer_id: int, order_data: schemas.TransactionCreate, request: Request, db: Session = Depends(get_db)):
     try:
-        return crud.create_order(db, customer_id, order_data)
+        order = crud.create_order(db, customer_id, order_data)
     except ValueError as e:
         raise HTTPException(status_code=400, detail=str(e))
+    # Заказ оформляется из корзины и очищает её
+    publish_cart(db, customer_id)
+    return negotiated(request, order, schemas.TransactionResponse)
 
 @router.delete("/cart/items/{item_id}")
 def remove_cart_item(item_id: int, db: Session = Depends(get_db)):
+    customer_id = crud.get_cart_item_customer_id(db, item_id)
     if not crud.remove_from_cart(db, item_id):
         raise HTTPException(status_code=404, detail="Cart item not found")
+    if customer_id is not None:
+        publish_cart(db, customer_id)
     return {"message": "Item removed from cart"}
 
 @router.delete("/customers/{customer_id}/cart")
 def clear_cart(customer_id: int, db: Session = Depends(get_db)):
     if not crud.clear_cart(db, customer_id):
         raise HTTPException(status_code=404, detail="Cart not found")
+    publish_cart(db, customer_id)
     return {"message": "Cart cleared"}
 
 @router.post("/customers/{customer_id}/orders", response_model=schemas.TransactionResponse)
 def create_order(
     customer_id: int,
     order_data: schemas.TransactionCreate,
+    request: Request,
     db: Session = Depends(get_db)
 ):
     try:
-        return crud.create_order(db, customer_id, order_data)
+        order = crud.create_order(db, customer_id, order_data)
     except ValueError as e:
         raise HTTPException(status_code=400, detail=str(e))
+    # Заказ оформляется из корзины и очищает её
+    publish_cart(db, customer_id)
+    return negotiated(request, order, schemas.TransactionResponse)
 
-@router.get("/customers/{customer_id}/orders", response_model=schemas.TransactionsList)
-def get_orders(customer_id: int, db: Session = Depends(get_db)):
-    return crud.get_orders(db, customer_id)
+@router.get("/customers/{customer_id}/orders", response_model=Union[schemas.OrdersPage, schemas.TransactionsList])
+def get_orders(
+    customer_id: int,
+    request: Request,
+    limit: Optional[int] = Query(None, ge=1, le=200),
+    before: Optional[str] = None,
+    db: Session = Depends(get_db)
+):
+    # С limit - страница заголовков заказов (от новых к старым) с курсором before на следующую;
+    # без него - вся история со строками, как раньше
+    if limit is None and before is None:
+        return negotiated(request, crud.get_orders(db, customer_id), schemas.TransactionsList)
+    try:
+        page = crud.get_orders_page(db, customer_id, limit or ORDERS_PAGE_SIZE, before)
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return negotiated(request, page, schemas.OrdersPage)
 
-@router.get("/orders/{order_id}", response_model=schemas.TransactionDetailResponse)
-def get_order_details(order_id: int, db: Session = Depends(get_db)):
-    order_details = crud.get_order_details(db, order_id)
-    if not order_details:
+@router.get("/orders/{order_id}", response_model=schemas.TransactionResponse)
+def get_order_details(order_id: int, request: Request, db: Session = Depends(get_db)):
+    order = crud.get_order_details(db, order_id)
+    if not order:
         raise HTTPException(status_code=404, detail="Order not found")
-    return order_details
+    return negotiated(request, order, schemas.TransactionResponse)
 
 @router.get("/products", response_model=schemas.ProductsList)
 def get_products(
+    request: Request,
     price_lt: float = None,
     price_gt: float = None,
     name: str = None,
     sort_by: str = None,
+    limit: Optional[int] = Query(None, ge=1, le=500),
+    after: Optional[str] = None,
     db: Session = Depends(get_db)
 ):
-    return crud.get_products(db, price_lt, price_gt, name, sort_by)
+    try:
+        products = crud.get_products(db, price_lt, price_gt, name, sort_by, limit, after)
+        return negotiated(request, products, schemas.ProductsList)
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
 
 @router.get("/products/search", response_model=schemas.ProductsList)
-def search_products(query: str, db: Session = Depends(get_db)):
+def search_products(
+    query: str,
+    request: Request,
+    limit: int = Query(100, ge=1, le=500),
+    db: Session = Depends(get_db)
+):
     if not query or len(query.strip()) < 2:
         raise HTTPException(
             status_code=400,
             detail="Search query must be at least 2 characters long"
         )
-    return crud.search_products(db, query)
+    return negotiated(request, crud.search_products(db, query, limit), schemas.ProductsList)
+
+@router.get("/products/version")
+def get_products_version(request: Request, db: Session = Depends(get_db)):
+    # Клиент с сохранённой копией каталога присылает её версию в If-None-Match и получает 304, если ничего не менялось
+    version = crud.get_catalog_version(db)
+    etag = f'"{version}"'
+    headers = {"ETag": etag, "Cache-Control": "no-cache"}
+    if etag in request.headers.get("if-none-match", ""):
+        return Response(status_code=304, headers=headers)
+    return JSONResponse({"version": version}, headers=headers)
+
+@router.get("/products/changes", response_model=schemas.CatalogChanges)
+def get_products_changes(request: Request, since: str, db: Session = Depends(get_db)):
+    # Изменения каталога после версии since: изменённые и новые товары плюс номера удалённых
+    try:
+        return negotiated(request, crud.get_catalog_changes(db, since), schemas.CatalogChanges)
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+
+IMAGE_SIGNATURES = (
+    (b"\x89PNG", "image/png"),
+    (b"\xff\xd8", "image/jpeg"),
+    (b"GIF8", "image/gif"),
+    (b"RIFF", "image/webp"),
+)
+
+@router.get("/products/{product_id}/image")
+def get_product_image(product_id: int, request: Request, v: Optional[str] = None, db: Session = Depends(get_db)):
+    image = crud.get_product_image(db, product_id)
+    if not image:
+        raise HTTPException(status_code=404, detail="Image not found")
+    content, image_hash = image
+
+    etag = f'"{image_hash}"'
+    # URL с ?v=<hash> никогда не меняет содержимое, его можно кэшировать навсегда;
+    # без версии клиент обязан перепроверять ETag
+    headers = {
+        "ETag": etag,
+        "Cache-Control": "public, max-age=31536000, immutable" if v == image_hash else "no-cache"
+    }
+    if etag in request.headers.get("if-none-match", ""):
+        return Response(status_code=304, headers=headers)
+
+    media_type = next((mime for signature, mime in IMAGE_SIGNATURES if content.startswith(signature)), "application/octet-stream")
+    return Response(content=content, media_type=media_type, headers=headers)
 
 @router.get("/products/{product_id}", response_model=schemas.Product)
 def get_product(product_id: int, db: Session = Depends(get_db)):
@@ -131,4 +303,7 @@ def get_product(product_id: int, db: Session = Depends(get_db)):
         raise HTTPException(status_code=404, detail="Product not found")
     return product
 
-
+@router.get("/metrics", include_in_schema=False)
+def get_metrics():
+    # Текстовый формат Prometheus; сервер метрик опрашивает этот адрес сам
+    return Response(content=metrics.render(), media_type=metrics.CONTENT_TYPE)
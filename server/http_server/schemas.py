@@ -57,7 +57,8 @@ class ProductBase(BaseModel):
     wholesale_price: float = Field(..., alias="WholesalePrice")
     retail_price: float = Field(..., alias="RetailPrice")
     description: Optional[str] = Field(None, alias="Description")  # Разрешаем None
-    image: Optional[str] = Field(None, alias="Image")  # Разрешаем None
+    image_hash: Optional[str] = Field(None, alias="ImageHash")  # Сама картинка отдаётся через /products/{id}/image
+    image_url: Optional[str] = Field(None, alias="ImageUrl")
 
 
 class Product(ProductBase):
@@ -72,7 +73,8 @@ class Product(ProductBase):
                 "WholesalePrice": data.WholesalePrice,
                 "RetailPrice": data.RetailPrice,
                 "Description": data.Description,
-                "Image": data.Image
+                "ImageHash": data.ImageHash,
+                "ImageUrl": f"/products/{data.ProductID}/image?v={data.ImageHash}" if data.ImageHash else None
             }
         return data
 
@@ -90,6 +92,14 @@ class CartItemBase(BaseModel):
 class CartItemCreate(CartItemBase):
     pass
 
+class CartOperation(BaseModel):
+    # Quantity прибавляется к количеству в корзине; отрицательное убирает товар, до нуля - удаляет строку
+    product_id: int = Field(..., alias="ProductID")
+    quantity: int = Field(..., alias="Quantity")
+
+class CartBatch(BaseModel):
+    operations: List[CartOperation] = Field(..., max_length=500)
+
 class CartItemUpdate(BaseModel):
     quantity: int = Field(..., gt=0)
 
@@ -189,6 +199,18 @@ class Discount(DiscountBase):
 # Lists
 class ProductsList(BaseModel):
     products: List[Product]
+    next_cursor: Optional[str] = None
+
+class CatalogChanges(BaseModel):
+    version: str
+    products: List[Product] = []
+    deleted: List[int] = []
+    has_more: bool = False
+    # true - версия клиента неизвестна серверу (например, база пересоздана), нужен полный каталог
+    reset: bool = False
+
+class DiscountsList(BaseModel):
+    discounts: List[Discount]
 
 class CartItemsList(BaseModel):
     items: List[CartItem]
@@ -206,5 +228,22 @@ class CartItemsList(BaseModel):
 class TransactionsList(BaseModel):
     transactions: List[TransactionResponse]
 
+# Заголовок заказа для истории: итоги посчитаны на сервере, строки запрашиваются отдельно (/orders/{id})
+class OrderSummary(BaseModel):
+    id: int = Field(..., alias="TransactionID")
+    employee_id: int = Field(..., alias="EmployeeID")
+    is_wholesale: bool = Field(..., alias="IsWholesale")
+    transaction_date: datetime = Field(..., alias="TransactionDate")
+    item_count: int
+    total_quantity: int
+    total_amount: float
+    discount_amount: float
+
+    model_config = ConfigDict(populate_by_name=True)
+
+class OrdersPage(BaseModel):
+    orders: List[OrderSummary]
+    next_cursor: Optional[str] = None
+
 
 
@@ -1,15 +1,26 @@
+import asyncio
 import pytest
 from unittest.mock import Mock
 from fastapi import HTTPException
+from sqlalchemy import create_engine, text
 from sqlalchemy.orm import Session
+from sqlalchemy.pool import StaticPool
 
 from http_server.crud import (
     get_customer_by_email,
     create_customer,
     add_to_cart,
+    search_match_expression,
+    search_products,
+    get_catalog_changes,
+    apply_cart_operations,
+    get_orders_page,
 )
-from http_server.models import Customer
-from http_server.schemas import CustomerCreate, CartItemCreate
+from http_server.discounts import DiscountIndex, DiscountTier
+from http_server.events import EventBus
+from http_server.metrics import Histogram
+from http_server.models import Base, Customer
+from http_server.schemas import CustomerCreate, CartItemCreate, CartOperation
 
 
 # Тест 1: Создание клиента
@@ -62,3 +73,121 @@ def test_add_nonexistent_product_to_cart():
 
 
 
+# Тест 4: Поисковый запрос экранируется для FTS5
+def test_search_match_expression():
+    assert search_match_expression('чай "зелёный" OR *') == '"чай"* "зелёный"* "OR"*'
+    assert search_match_expression('*:()') is None
+
+
+# Тест 5: Некорректная версия каталога в запросе изменений
+def test_catalog_changes_invalid_version():
+    mock_db = Mock(spec=Session)
+
+    with pytest.raises(ValueError):
+        get_catalog_changes(mock_db, "latest")
+    mock_db.query.assert_not_called()
+
+
+# Тест 6: Событие корзины доходит только до подписчиков этого покупателя
+def test_event_bus_publish_to_customer():
+    async def scenario():
+        bus = EventBus()
+        first = bus.subscribe(1)
+        second = bus.subscribe(2)
+
+        # Обработчики запросов публикуют из пула потоков
+        await asyncio.to_thread(bus.publish, "cart", {"total_items": 3}, 1)
+        message = await asyncio.wait_for(first.queue.get(), 1)
+        await asyncio.sleep(0)
+
+        assert message == 'event: cart\ndata: {"total_items":3}\n\n'
+        assert second.queue.empty()
+
+        bus.unsubscribe(first)
+        bus.unsubscribe(second)
+        assert not bus.has_subscribers()
+
+    asyncio.run(scenario())
+
+
+# Тест 7: Пакет изменений корзины с несуществующим товаром отклоняется целиком
+def test_cart_batch_with_nonexistent_product():
+    mock_db = Mock(spec=Session)
+
+    mock_db.query.return_value.filter.return_value.all.return_value = [(1,)]
+
+    operations = [CartOperation(ProductID=1, Quantity=2), CartOperation(ProductID=999, Quantity=1)]
+
+    with pytest.raises(HTTPException) as exc_info:
+        apply_cart_operations(mock_db, 1, operations)
+
+    assert exc_info.value.status_code == 404
+    assert "999" in str(exc_info.value.detail)
+    mock_db.commit.assert_not_called()
+
+
+# Тест 8: Индекс скидок выбирает ступень с наибольшей ставкой по количеству и сумме
+def test_discount_index_find():
+    index = DiscountIndex([
+        DiscountTier(DiscountID=1, MinQuantity=2, MaxQuantity=100, DiscountRate=0.05, MinTotalPrice=0.0),
+        DiscountTier(DiscountID=2, MinQuantity=5, MaxQuantity=10, DiscountRate=0.1, MinTotalPrice=100.0),
+    ])
+
+    assert index.find(1, 50.0) is None
+    assert index.find(0, 0.0) is None
+    assert index.find(5, 50.0).DiscountID == 1
+    assert index.find(5, 100.0).DiscountID == 2
+    assert index.find(10, 500.0).DiscountID == 2
+    assert index.find(11, 500.0).DiscountID == 1
+    assert index.find(101, 500.0) is None
+
+
+# Тест 9: Некорректный курсор истории заказов
+def test_orders_page_invalid_cursor():
+    mock_db = Mock(spec=Session)
+
+    with pytest.raises(ValueError):
+        get_orders_page(mock_db, 1, 10, "garbage")
+
+    mock_db.execute.assert_not_called()
+
+
+# Тест 10: Гистограмма метрик в формате Prometheus с накопленными корзинами
+def test_metrics_histogram_render():
+    histogram = Histogram("test_seconds", "Тест", (0.1, 1.0))
+    histogram.observe(0.05, route="/a")
+    histogram.observe(0.5, route="/a")
+    histogram.observe(5.0, route="/a")
+
+    text = histogram.render()
+
+    assert '# TYPE test_seconds histogram' in text
+    assert 'test_seconds_bucket{route="/a",le="0.1"} 1' in text
+    assert 'test_seconds_bucket{route="/a",le="1.0"} 2' in text
+    assert 'test_seconds_bucket{route="/a",le="+Inf"} 3' in text
+    assert 'test_seconds_count{route="/a"} 3' in text
+
+
+# Тест 11: Общий запрос возвращает самые релевантные товары, а не первые найденные
+def test_search_ranks_all_matches():
+    engine = create_engine("sqlite://", connect_args={"check_same_thread": False}, poolclass=StaticPool)
+    Base.metadata.create_all(bind=engine)
+    with engine.begin() as connection:
+        connection.execute(text("CREATE VIRTUAL TABLE ProductsFTS USING fts5(Name, Description)"))
+        # Слово в описании у первых 1500 товаров и в названии только у последнего
+        for product_id in range(1, 1502):
+            name = "Чай улун" if product_id == 1501 else f"Товар {product_id}"
+            row = {"id": product_id, "name": name, "description": "чай в пакетиках"}
+            connection.execute(text(
+                "INSERT INTO Products (ProductID, Name, WholesalePrice, RetailPrice, Description, ChangeVersion) "
+                "VALUES (:id, :name, 1, 2, :description, 0)"
+            ), row)
+            connection.execute(text(
+                "INSERT INTO ProductsFTS (rowid, Name, Description) VALUES (:id, :name, :description)"
+            ), row)
+
+    with Session(engine) as db:
+        result = search_products(db, "чай", limit=10)
+
+    assert len(result.products) == 10
+    assert result.products[0].id == 1501